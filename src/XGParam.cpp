@@ -21,12 +21,23 @@
 
 #include "XGParam.h"
 
+#include "qxgeditProfile.h"
+
 #include <QRegularExpression>
 
+#include <algorithm>
+
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <ctime>
+#include <new>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // Table (2D-array) size in elements.
 #define TSIZE(tab)	(sizeof(tab) / sizeof(tab[0]))
@@ -639,8 +650,10 @@ static
 const char *getschan ( unsigned short c )
 {
 	if (c < 16) {
-		static char chan[4];
-		snprintf(chan, sizeof(chan), "%u", c + 1);
+		static char tabchan[16][4];
+		char *chan = tabchan[c];
+		if (chan[0] == '\0')
+			snprintf(chan, sizeof(tabchan[c]), "%u", c + 1);
 		return chan;
 	}
 	else if (c == 127)
@@ -661,8 +674,10 @@ static
 const char *getsvpan ( unsigned short c )
 {
 	if (c < 15) {
-		static char vpan[3];
-		snprintf(vpan, sizeof(vpan), "%2d", int(c) - 7);
+		static char tabvpan[15][3];
+		char *vpan = tabvpan[c];
+		if (vpan[0] == '\0')
+			snprintf(vpan, sizeof(tabvpan[c]), "%2d", int(c) - 7);
 		return vpan;
 	}
 	else if (c == 15)
@@ -677,9 +692,12 @@ const char *getsnote ( unsigned short c )
 	static
 	const char *tabnote[] =
 		{ "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+	static char tabnotes[128][8];
 	static char note[8];
-	snprintf(note, sizeof(note), "%-2s%2d", tabnote[c % 12], (c / 12) - 1);
-	return note;
+	char *pnote = (c < 128 ? tabnotes[c] : note);
+	if (pnote[0] == '\0' || pnote == note)
+		snprintf(pnote, sizeof(note), "%-2s%2d", tabnote[c % 12], (c / 12) - 1);
+	return pnote;
 }
 
 
@@ -1963,6 +1981,8 @@ struct _XGEffectParamItem
 	unsigned short (*getu)(float);          // invert to native value.
 	const char *   (*gets)(unsigned short); // enumerated string value.
 	const char *   (*unit)();               // unit suffix label.
+	mutable XGParamText *text;              // cached label/text (lazy).
+	mutable XGParamTable *table;            // display value tables (lazy).
 
 } XGEffectParamItem;
 
@@ -2642,10 +2662,88 @@ struct _XGParamItem
 	unsigned short (*getu)(float);          // invert to native value.
 	const char *   (*gets)(unsigned short); // enumerated string value.
 	const char *   (*unit)();               // unit suffix label.
+	mutable XGParamText *text;              // cached label/text (lazy).
+	mutable XGParamTable *table;            // display value tables (lazy).
 
 } XGParamItem;
 
 
+//-------------------------------------------------------------------------
+// Display value lookup tables (per descriptor entry, built once).
+//
+
+// Display value table slots in use (released on teardown).
+static QList<XGParamTable **> g_param_tables;
+
+static void param_tables_clear (void)
+{
+	QListIterator<XGParamTable **> iter(g_param_tables);
+	while (iter.hasNext()) {
+		XGParamTable **pptable = iter.next();
+		XGParamTable *ptable = *pptable;
+		delete [] ptable->gets;
+		delete [] ptable->getv;
+		delete ptable;
+		*pptable = nullptr;
+	}
+
+	g_param_tables.clear();
+}
+
+template <typename T>
+static const XGParamTable *param_table ( const T *item )
+{
+	XGParamTable *ptable = item->table;
+	if (ptable)
+		return ptable;
+
+	ptable = new XGParamTable;
+	ptable->min  = item->min;
+	ptable->max  = item->max;
+	ptable->getv = nullptr;
+	ptable->gets = nullptr;
+
+	// Up to 14bit value ranges only...
+	const int n = int(item->max) - int(item->min) + 1;
+	if (n > 0 && n <= 0x4000) {
+		if (item->getv) {
+			ptable->getv = new float [n];
+			for (int i = 0; i < n; ++i)
+				ptable->getv[i] = item->getv(item->min + i);
+		}
+		if (item->gets) {
+			ptable->gets = new const char * [n];
+			for (int i = 0; i < n; ++i)
+				ptable->gets[i] = item->gets(item->min + i);
+		}
+	}
+
+	item->table = ptable;
+	g_param_tables.append(&(item->table));
+	return ptable;
+}
+
+template <typename T>
+static float param_getv ( const T *item, unsigned short u )
+{
+	const XGParamTable *ptable = param_table(item);
+	if (ptable->getv && u >= ptable->min && u <= ptable->max)
+		return ptable->getv[u - ptable->min];
+	else
+		return item->getv(u);
+}
+
+template <typename T>
+static const char *param_gets ( const T *item, unsigned short u )
+{
+	const XGParamTable *ptable = param_table(item);
+	if (ptable->gets && u >= ptable->min && u <= ptable->max)
+		return ptable->gets[u - ptable->min];
+	else
+		return item->gets(u);
+}
+
+
 //-------------------------------------------------------------------------
 // XG Parameter tables
 
@@ -3022,141 +3120,129 @@ XGRpnParamItem NRPNParamTab[] =
 
 //-------------------------------------------------------------------------
 // XG Effect table helpers.
+//
+// Direct-index lookup, by effect type (etype = (msb << 7) + lsb;
+// all tabled LSB values are less than 16), built once on first use.
 
-static inline
-const XGEffectItem *XGEffectItem_find (
-	unsigned short etype, XGEffectItem items[], unsigned short nitems )
+class XGEffectItemIndex
 {
-	unsigned short i;
+public:
 
-	for (i = 0; i < nitems; ++i) {
-		XGEffectItem *item = &items[i];
-		if (((item->msb << 7) + item->lsb) == etype)
-			return item;
+	XGEffectItemIndex ( XGEffectItem items[], unsigned short nitems )
+	{
+		::memset(m_items, 0, sizeof(m_items));
+		for (unsigned short i = 0; i < nitems; ++i) {
+			XGEffectItem *item = &items[i];
+			m_items[(item->msb << 4) + (item->lsb & 0x0f)] = item;
+		}
 	}
 
-	return nullptr;
-}
+	const XGEffectItem *find ( unsigned short etype ) const
+	{
+		const unsigned short msb = (etype >> 7) & 0x7f;
+		const unsigned short lsb = (etype & 0x7f);
+		return (lsb < 0x10 ? m_items[(msb << 4) + lsb] : nullptr);
+	}
+
+private:
+
+	const XGEffectItem *m_items[0x800];
+};
 
 
 static inline
 const XGEffectItem *REVERBEffectItem ( unsigned short etype )
 {
-	return XGEffectItem_find(etype,
+	static const XGEffectItemIndex s_index(
 		REVERBEffectTab, TSIZE(REVERBEffectTab));
+	return s_index.find(etype);
 }
 
 static inline
 const XGEffectItem *CHORUSEffectItem ( unsigned short etype )
 {
-	return XGEffectItem_find(etype,
+	static const XGEffectItemIndex s_index(
 		CHORUSEffectTab, TSIZE(CHORUSEffectTab));
+	return s_index.find(etype);
 }
 
 static inline
 const XGEffectItem *VARIATIONEffectItem ( unsigned short etype )
 {
-	return XGEffectItem_find(etype,
+	static const XGEffectItemIndex s_index(
 		VARIATIONEffectTab, TSIZE(VARIATIONEffectTab));
+	return s_index.find(etype);
 }
 
 
 //-------------------------------------------------------------------------
-// XG Effect default helpers.
+// XG Parameter table helpers.
+//
+// Direct-index lookup, by id (low address), built once on first use.
 
-static inline
-unsigned short XGEffectDefault_find (
-	unsigned short etype, unsigned short index,
-	XGEffectItem items[], unsigned short nitems,
-	unsigned short defaults[][16] )
+class XGParamItemIndex
 {
-	unsigned short i;
+public:
 
-	for (i = 0; i < nitems; ++i) {
-		XGEffectItem *item = &items[i];
-		if (((item->msb << 7) + item->lsb) == etype)
-			return defaults[i][index];
+	XGParamItemIndex ( XGParamItem items[], unsigned short nitems )
+	{
+		::memset(m_items, 0, sizeof(m_items));
+		for (unsigned short i = 0; i < nitems; ++i) {
+			XGParamItem *item = &items[i];
+			if (item->id < 0x100)
+				m_items[item->id] = item;
+		}
 	}
 
-	return 0;
-}
-
-
-static inline
-unsigned short REVERBEffectDefault (
-	unsigned short etype, unsigned short index )
-{
-	return XGEffectDefault_find(etype, index,
-		REVERBEffectTab, TSIZE(REVERBEffectTab),
-		REVERBDefaultTab);
-}
-
-static inline
-unsigned short CHORUSEffectDefault (
-	unsigned short etype, unsigned short index )
-{
-	return XGEffectDefault_find(etype, index,
-		CHORUSEffectTab, TSIZE(CHORUSEffectTab),
-		CHORUSDefaultTab);
-}
-
-static inline
-unsigned short VARIATIONEffectDefault (
-	unsigned short etype, unsigned short index )
-{
-	return XGEffectDefault_find(etype, index,
-		VARIATIONEffectTab, TSIZE(VARIATIONEffectTab),
-		VARIATIONDefaultTab);
-}
-
-
-//-------------------------------------------------------------------------
-// XG Parameter table helpers.
-
-static inline
-const XGParamItem *XGParamItem_find (
-	unsigned short id, XGParamItem items[], unsigned short nitems )
-{
-	unsigned short i;
-
-	for (i = 0; i < nitems; ++i) {
-		XGParamItem *item = &items[i];
-		if (item->id == id)
-			return item;
+	const XGParamItem *find ( unsigned short id ) const
+	{
+		return (id < 0x100 ? m_items[id] : nullptr);
 	}
 
-	return nullptr;
-}
+private:
+
+	const XGParamItem *m_items[0x100];
+};
 
 
 static inline
 const XGParamItem *SYSTEMParamItem ( unsigned short id )
 {
-	return XGParamItem_find(id, SYSTEMParamTab, TSIZE(SYSTEMParamTab));
+	static const XGParamItemIndex s_index(
+		SYSTEMParamTab, TSIZE(SYSTEMParamTab));
+	return s_index.find(id);
 }
 
 static inline
 const XGParamItem *EFFECTParamItem ( unsigned short id )
 {
-	return XGParamItem_find(id, EFFECTParamTab, TSIZE(EFFECTParamTab));
+	static const XGParamItemIndex s_index(
+		EFFECTParamTab, TSIZE(EFFECTParamTab));
+	return s_index.find(id);
 }
 
 static inline
 const XGParamItem *MULTIPARTParamItem ( unsigned short id )
 {
-	return XGParamItem_find(id, MULTIPARTParamTab, TSIZE(MULTIPARTParamTab));
+	static const XGParamItemIndex s_index(
+		MULTIPARTParamTab, TSIZE(MULTIPARTParamTab));
+	return s_index.find(id);
 }
 
 static inline
 const XGParamItem *DRUMSETUPParamItem ( unsigned short id )
 {
-	return XGParamItem_find(id, DRUMSETUPParamTab, TSIZE(DRUMSETUPParamTab));
+	static const XGParamItemIndex s_index(
+		DRUMSETUPParamTab, TSIZE(DRUMSETUPParamTab));
+	return s_index.find(id);
 }
 
 static inline
 const XGParamItem *USERVOICEParamItem ( unsigned short id )
 {
-	return XGParamItem_find(id, USERVOICEParamTab, TSIZE(USERVOICEParamTab));
+	static const XGParamItemIndex s_index(
+		USERVOICEParamTab, TSIZE(USERVOICEParamTab));
+	return s_index.find(id);
 }
 
 
@@ -3340,7 +3426,8 @@ const char *XGDrumVoice::name (void) const
 
 // Constructor.
 XGParam::XGParam ( unsigned short high, unsigned short mid, unsigned short low )
-	: m_param(nullptr), m_value(0),
+	: m_param(nullptr), m_eparam(nullptr), m_value(&m_value0),
+		m_etype(0), m_edef(0), m_kind(Plain), m_value0(0),
 		m_high(high), m_mid(mid), m_low(low), m_busy(false)
 {
 	if (m_high == 0x00 && m_mid == 0x00) {
@@ -3371,11 +3458,11 @@ XGParam::XGParam ( unsigned short high, unsigned short mid, unsigned short low )
 
 	// Set initial defaults.
 	if (m_param)
-		m_value = XGParam::def();
+		*m_value = XGParam::def();
 }
 
 
-// Virtual destructor.
+// Destructor.
 XGParam::~XGParam (void)
 {
 	m_busy = true;
@@ -3388,6 +3475,13 @@ XGParam::~XGParam (void)
 }
 
 
+// Parameter kind (dispatch tag).
+XGParam::Kind XGParam::kind (void) const
+{
+	return Kind(m_kind);
+}
+
+
 // Address acessors.
 unsigned short XGParam::high (void) const
 {
@@ -3405,6 +3499,13 @@ unsigned short XGParam::low (void) const
 }
 
 
+// Sub-address accessors (effect type; 0 if none).
+unsigned short XGParam::etype (void) const
+{
+	return m_etype;
+}
+
+
 // Number of bytes needed to encode subject.
 unsigned short XGParam::size (void) const
 {
@@ -3412,24 +3513,38 @@ unsigned short XGParam::size (void) const
 }
 
 
-// Virtual accessors.
+// Descriptor accessors (effect sub-descriptor first, if any).
 const char *XGParam::name (void) const
 {
+	if (m_eparam)
+		return m_eparam->name;
+
 	return (m_param ? m_param->name : nullptr);
 }
 
 unsigned short XGParam::min (void) const
 {
+	if (m_eparam)
+		return m_eparam->min;
+
 	return (m_param ? m_param->min : 0);
 }
 
 unsigned short XGParam::max (void) const
 {
+	if (m_eparam)
+		return m_eparam->max;
+
 	return (m_param ? m_param->max : 0);
 }
 
 unsigned short XGParam::def (void) const
 {
+	// Effect type dependent defaults...
+	if (m_kind == Effect && m_param
+		&& m_param->name == nullptr && m_param->min < 3)
+		return m_edef;
+
 	// Take care of very special, hardcoded cases, here...
 	if (m_high == 0x08) {
 		switch (m_low) {
@@ -3449,21 +3564,33 @@ unsigned short XGParam::def (void) const
 
 float XGParam::getv ( unsigned short u ) const
 {
-	return (m_param && m_param->getv ? m_param->getv(u) : float(u));
+	if (m_eparam && m_eparam->getv)
+		return param_getv(m_eparam, u);
+
+	return (m_param && m_param->getv ? param_getv(m_param, u) : float(u));
 }
 
 unsigned short XGParam::getu ( float v ) const
 {
+	if (m_eparam && m_eparam->getu)
+		return m_eparam->getu(v);
+
 	return (m_param && m_param->getu ? m_param->getu(v) : (unsigned short) (v));
 }
 
 const char *XGParam::gets ( unsigned short u ) const
 {
-	return (m_param && m_param->gets ? m_param->gets(u) : nullptr);
+	if (m_eparam && m_eparam->gets)
+		return param_gets(m_eparam, u);
+
+	return (m_param && m_param->gets ? param_gets(m_param, u) : nullptr);
 }
 
 const char *XGParam::unit (void) const
 {
+	if (m_eparam && m_eparam->unit)
+		return m_eparam->unit();
+
 	return (m_param && m_param->unit ? m_param->unit() : nullptr);
 }
 
@@ -3522,14 +3649,14 @@ void XGParam::set_value_update ( unsigned short u, XGParamObserver *sender )
 	if (gets(min()) && !gets(u))
 		return;
 
-	m_value = u;
+	*m_value = u;
 
 	notify_update(sender);
 }
 
 void XGParam::set_value ( unsigned short u, XGParamObserver *sender )
 {
-	if (m_value == u)
+	if (*m_value == u)
 		return;
 
 	set_value_update(u, sender);
@@ -3537,14 +3664,25 @@ void XGParam::set_value ( unsigned short u, XGParamObserver *sender )
 
 unsigned short XGParam::value (void) const
 {
-	return m_value;
+	return *m_value;
+}
+
+
+// Value storage relocation (master value plane slot).
+void XGParam::set_value_slot ( unsigned short *pvalue )
+{
+	*pvalue = *m_value;
+	m_value = pvalue;
 }
 
 
 // Value reset (to default).
 void XGParam::reset ( XGParamObserver *sender )
 {
-	set_value(def(), sender);
+	if (m_kind == Data)
+		static_cast<XGDataParam *> (this)->reset(sender);
+	else
+		set_value(def(), sender);
 }
 
 
@@ -3581,6 +3719,11 @@ void XGParam::notify_update ( XGParamObserver *sender )
 	if (m_busy)
 		return;
 
+	// Deferred to batched apply commit?
+	XGParamMasterMap *pMasterMap = XGParamMasterMap::getInstance();
+	if (pMasterMap && pMasterMap->defer_update(this, sender))
+		return;
+
 	m_busy = true;
 
 	QListIterator<XGParamObserver *> iter(m_observers);
@@ -3616,31 +3759,67 @@ const QList<XGParamObserver *>& XGParam::observers (void) const
 // Textual (name parsed) representations.
 QString XGParam::label (void) const
 {
-	QString slabel;
+	const XGParamText *ptext = param_text();
+	return (ptext ? ptext->label : QString());
+}
+
+QString XGParam::text (void) const
+{
+	const XGParamText *ptext = param_text();
+	return (ptext ? ptext->text : QString());
+}
+
 
-	const char *plabel = name();
-	if (plabel) {
-		slabel = plabel;
-		slabel.remove(QRegularExpression("\\[[^\\]]*\\]"));
+// Textual representations cache slots in use (released on teardown).
+static QList<XGParamText **> g_param_texts;
+
+static void param_texts_clear (void)
+{
+	QListIterator<XGParamText **> iter(g_param_texts);
+	while (iter.hasNext()) {
+		XGParamText **pptext = iter.next();
+		delete *pptext;
+		*pptext = nullptr;
 	}
 
-	return slabel;
+	g_param_texts.clear();
 }
 
-QString XGParam::text (void) const
+
+// Textual representations cache (shared per descriptor entry).
+const XGParamText *XGParam::param_text (void) const
 {
-	QString stext;
+	XGParamText **pptext = nullptr;
+	if (m_eparam)
+		pptext = &(m_eparam->text);
+	else
+	if (m_param)
+		pptext = &(m_param->text);
+	if (pptext == nullptr)
+		return nullptr;
 
-	const char *ptext = name();
-	if (ptext) {
-		stext = ptext;
-		stext.remove('[').remove(']');
-		const char *punit = unit();
-		if (punit)
-			stext += QString(" (%1)").arg(punit);
-	}
+	XGParamText *ptext = *pptext;
+	if (ptext)
+		return ptext;
 
-	return stext;
+	const char *pname = name();
+	if (pname == nullptr)
+		return nullptr;
+
+	static const QRegularExpression s_rx("\\[[^\\]]*\\]");
+
+	ptext = new XGParamText;
+	ptext->label = pname;
+	ptext->label.remove(s_rx);
+	ptext->text = pname;
+	ptext->text.remove('[').remove(']');
+	const char *punit = unit();
+	if (punit)
+		ptext->text += QString(" (%1)").arg(punit);
+
+	*pptext = ptext;
+	g_param_texts.append(pptext);
+	return ptext;
 }
 
 
@@ -3674,9 +3853,11 @@ void XGParam::randomize_def ( float p )
 // Constructor.
 XGEffectParam::XGEffectParam (
 	unsigned short high, unsigned short mid, unsigned short low,
-	unsigned short etype) : XGParam(high, mid, low),
-		m_etype(etype), m_eparam(nullptr)
+	unsigned short etype) : XGParam(high, mid, low)
 {
+	m_kind = Effect;
+	m_etype = etype;
+
 	if (m_param && m_param->name == nullptr) {
 		const XGEffectItem *effect = nullptr;
 		switch (m_param->min) {
@@ -3692,68 +3873,13 @@ XGEffectParam::XGEffectParam (
 		}
 		if (effect && effect->params)
 			m_eparam = &(effect->params[m_param->max]);
+		if (effect && effect->defs && m_param->min < 3)
+			m_edef = effect->defs[m_param->max];
 	}
 
 	// Re(set) initial defaults.
 	if (m_eparam)
-		m_value = XGEffectParam::def();
-}
-
-
-// Sub-address accessors.
-unsigned short XGEffectParam::etype (void)  const
-{
-	return m_etype;
-}
-
-
-// Virtual accessors.
-const char *XGEffectParam::name (void) const
-{
-	return (m_eparam ? m_eparam->name : XGParam::name());
-}
-
-unsigned short XGEffectParam::min (void) const
-{
-	return (m_eparam ? m_eparam->min : XGParam::min());
-}
-
-unsigned short XGEffectParam::max (void) const
-{
-	return (m_eparam ? m_eparam->max : XGParam::max());
-}
-
-unsigned short XGEffectParam::def (void) const
-{
-	if (m_param && m_param->name == nullptr) {
-		switch (m_param->min) {
-			case 0: return REVERBEffectDefault(m_etype, m_param->max);
-			case 1: return CHORUSEffectDefault(m_etype, m_param->max);
-			case 2: return VARIATIONEffectDefault(m_etype, m_param->max);
-		}
-	}
-
-	return XGParam::def();
-}
-
-float XGEffectParam::getv ( unsigned short u ) const
-{
-	return (m_eparam && m_eparam->getv ? m_eparam->getv(u) : XGParam::getv(u));
-}
-
-unsigned short XGEffectParam::getu ( float v ) const
-{
-	return (m_eparam && m_eparam->getu ? m_eparam->getu(v) : XGParam::getu(v));
-}
-
-const char *XGEffectParam::gets ( unsigned short u ) const
-{
-	return (m_eparam && m_eparam->gets ? m_eparam->gets(u) : XGParam::gets(u));
-}
-
-const char *XGEffectParam::unit (void) const
-{
-	return (m_eparam && m_eparam->unit ? m_eparam->unit() : XGParam::unit());
+		*m_value = def();
 }
 
 
@@ -3765,6 +3891,8 @@ XGDataParam::XGDataParam (
 	unsigned short high, unsigned short mid, unsigned short low )
 	: XGParam(high, mid, low)
 {
+	m_kind = Data;
+
 	unsigned short n = size();
 	m_data = new unsigned char [n];
 	::memset(m_data, ' ', n);
@@ -3773,7 +3901,7 @@ XGDataParam::XGDataParam (
 // Destructor.
 XGDataParam::~XGDataParam (void)
 {
-	delete m_data;
+	delete [] m_data;
 }
 
 
@@ -3834,6 +3962,13 @@ void XGParamMap::add_param ( XGParam *param, unsigned short key )
 	XGParamSet *paramset = find_paramset(param->low());
 	paramset->insert(key, param);
 
+	// Keep key spans in id order...
+	Params& params = m_key_params[key];
+	int i = params.count();
+	while (i > 0 && params.at(i - 1)->low() > param->low())
+		--i;
+	params.insert(i, param);
+
 	XGParamMasterMap *pMasterMap = XGParamMasterMap::getInstance();
 	if (pMasterMap)
 		pMasterMap->add_param_map(param, this);
@@ -3848,6 +3983,8 @@ XGParam *XGParamMap::find_param ( unsigned short id )
 		return nullptr;
 
 	unsigned short key = current_key();
+	materialize(key);
+
 	return (paramset->contains(key) ? paramset->value(key) : nullptr);
 }
 
@@ -3901,28 +4038,94 @@ XGParamSet *XGParamMap::find_paramset ( unsigned short id )
 }
 
 
+// Key param span (all params of a key, in id order).
+XGParamMap::Params XGParamMap::key_params ( unsigned short key ) const
+{
+	return m_key_params.value(key);
+}
+
+
+// Element stride filter (USERVOICE, QS300).
+bool XGParamMap::element_param ( XGParam *param ) const
+{
+	const unsigned short id = param->low();
+	if (m_elements < 1 || id < 0x3d)
+		return true;
+
+	const unsigned short id0 = 0x3d + (m_element * 0x50);
+	return (id >= id0 && id < id0 + 0x50);
+}
+
+
+// Lazy param set materialization (effect types).
+void XGParamMap::materialize ( unsigned short key )
+{
+	if (m_key_param == nullptr)
+		return;
+
+	XGParamMasterMap *pMasterMap = XGParamMasterMap::getInstance();
+	if (pMasterMap)
+		pMasterMap->materialize(this, key);
+}
+
+
 // Local observers notify (key change).
 void XGParamMap::notify_reset (void)
 {
 	if (m_key_param)
 		m_key = m_key_param->value();
 
-	unsigned short id0 = 0x3d + (m_element * 0x50);
-	XGParamMap::const_iterator iter = XGParamMap::constBegin();
-	for (; iter != XGParamMap::constEnd(); ++iter) {
-		unsigned short id = iter.key();
-		if (m_elements > 0 && id >= 0x3d && (id < id0 || id >= id0 + 0x50))
-			continue;
-		XGParamSet *paramset = iter.value();
-		if (paramset->contains(m_key)) {
-			XGParam *param = paramset->value(m_key);
-			if (param)
-				param->notify_reset();
-		}
+	materialize(m_key);
+	rebind();
+
+	QListIterator<XGParam *> iter(m_key_params.value(m_key));
+	while (iter.hasNext()) {
+		XGParam *param = iter.next();
+		if (element_param(param))
+			param->notify_reset();
 	}
 }
 
 
+// Rebindable observers (re-pointed on key/element change).
+void XGParamMap::bind ( XGParamObserver *observer, unsigned short id )
+{
+	m_bound.insert(observer, id);
+
+	materialize(current_key());
+	rebind(observer, id);
+}
+
+void XGParamMap::unbind ( XGParamObserver *observer )
+{
+	m_bound.remove(observer);
+}
+
+
+// Rebind observer(s) to current key/element param.
+void XGParamMap::rebind ( XGParamObserver *observer, unsigned short id )
+{
+	if (m_elements > 0 && id >= 0x3d)
+		id += (m_element * 0x50);
+
+	XGParamSet *paramset = XGParamMap::value(id, nullptr);
+	if (paramset == nullptr)
+		return;
+
+	XGParam *param = paramset->value(current_key(), nullptr);
+	if (param && param != observer->param())
+		observer->set_param(param);
+}
+
+void XGParamMap::rebind (void)
+{
+	QHash<XGParamObserver *, unsigned short>::const_iterator iter
+		= m_bound.constBegin();
+	for (; iter != m_bound.constEnd(); ++iter)
+		rebind(iter.key(), iter.value());
+}
+
+
 // Key/type name stuff.
 const XGParamMap::Keys& XGParamMap::keys (void) const
 {
@@ -3952,19 +4155,15 @@ void XGParamMap::set_current_element ( unsigned short element )
 {
 	m_element = element;
 
-	unsigned short key = current_key();
+	rebind();
+
 	unsigned short id0 = 0x3d + (m_element * 0x50);
-	XGParamMap::const_iterator iter = XGParamMap::constBegin();
-	for (; iter != XGParamMap::constEnd(); ++iter) {
-		unsigned short id = iter.key();
-		if (id >= id0 && id < id0 + 0x50) {
-			XGParamSet *paramset = iter.value();
-			if (paramset->contains(key)) {
-				XGParam *param = paramset->value(key);
-				if (param)
-					param->notify_reset();
-			}
-		}
+	QListIterator<XGParam *> iter(m_key_params.value(current_key()));
+	while (iter.hasNext()) {
+		XGParam *param = iter.next();
+		const unsigned short id = param->low();
+		if (id >= id0 && id < id0 + 0x50)
+			param->notify_reset();
 	}
 }
 
@@ -3978,15 +4177,11 @@ unsigned short XGParamMap::current_element (void) const
 void XGParamMap::reset ( XGParamObserver *sender )
 {
 	unsigned short key = current_key();
-	XGParamMap::const_iterator iter = XGParamMap::constBegin();
-	for (; iter != XGParamMap::constEnd(); ++iter) {
-		XGParamSet *paramset = iter.value();
-		if (paramset->contains(key)) {
-			XGParam *param = paramset->value(key);
-			if (param)
-				param->reset(sender);
-		}
-	}
+	materialize(key);
+
+	QListIterator<XGParam *> iter(m_key_params.value(key));
+	while (iter.hasNext())
+		iter.next()->reset(sender);
 }
 
 
@@ -3994,110 +4189,269 @@ void XGParamMap::reset ( XGParamObserver *sender )
 void XGParamMap::randomize_value ( int p )
 {
 	unsigned short key = current_key();
-	unsigned short id0 = 0x3d + (m_element * 0x50);
-	XGParamMap::const_iterator iter = XGParamMap::constBegin();
-	for (; iter != XGParamMap::constEnd(); ++iter) {
-		unsigned short id = iter.key();
-		if (m_elements > 0 && id >= 0x3d && (id < id0 || id >= id0 + 0x50))
-			continue;
-		XGParamSet *paramset = iter.value();
-		if (paramset->contains(key)) {
-			XGParam *param = paramset->value(key);
-			if (param)
-				param->randomize_value(p);
-		}
+	materialize(key);
+
+	QListIterator<XGParam *> iter(m_key_params.value(key));
+	while (iter.hasNext()) {
+		XGParam *param = iter.next();
+		if (element_param(param))
+			param->randomize_value(p);
 	}
 }
 
 void XGParamMap::randomize_def ( int p )
 {
 	unsigned short key = current_key();
-	unsigned short id0 = 0x3d + (m_element * 0x50);
-	XGParamMap::const_iterator iter = XGParamMap::constBegin();
-	for (; iter != XGParamMap::constEnd(); ++iter) {
-		unsigned short id = iter.key();
-		if (m_elements > 0 && id >= 0x3d && (id < id0 || id >= id0 + 0x50))
-			continue;
-		XGParamSet *paramset = iter.value();
-		if (paramset->contains(key)) {
-			XGParam *param = paramset->value(key);
-			if (param)
-				param->randomize_def(p);
-		}
+	materialize(key);
+
+	QListIterator<XGParam *> iter(m_key_params.value(key));
+	while (iter.hasNext()) {
+		XGParam *param = iter.next();
+		if (element_param(param))
+			param->randomize_def(p);
 	}
 }
 
 
 //-------------------------------------------------------------------------
-// class XGParamMasterMap - XG Parameter master state database.
+// XG bulk block layouts (field offset, width and codec; offset ordered).
 //
-// Pseudo-singleton reference.
-XGParamMasterMap *XGParamMasterMap::g_pParamMasterMap = nullptr;
 
-// Pseudo-singleton accessor (static).
-XGParamMasterMap *XGParamMasterMap::getInstance (void)
+static bool xgparam_field_less ( const XGParamField& f1, const XGParamField& f2 )
 {
-	return g_pParamMasterMap;
+	return (f1.low < f2.low);
 }
 
-
-// Constructor.
-XGParamMasterMap::XGParamMasterMap (void)
+static XGParamLayout xgparam_layout ( const XGParamItem *tab,
+	unsigned short n, unsigned short high, unsigned short stride = 0 )
 {
-	unsigned short i, j, k;
-
-	// Initialize the randomizer seed...
-	::srand(::time(nullptr));
+	XGParamField *fields = new XGParamField [stride > 0 ? n << 1 : n];
+	unsigned short count = 0;
+	unsigned short size = 0;
 
-	// XG SYSTEM...
-	for (i = 0; i < TSIZE(SYSTEMParamTab); ++i) {
-		XGParamItem *item = &SYSTEMParamTab[i];
-		XGParam *param = new XGParam(0x00, 0x00, item->id);
-		XGParamMasterMap::add_param(param);
-		SYSTEM.add_param(param, 0);
+	for (unsigned short i = 0; i < n; ++i) {
+		const XGParamItem *item = &tab[i];
+		XGParamField field;
+		field.low  = item->id;
+		field.size = item->size;
+		if (item->size > 4)
+			field.codec = XGParamField::Data;
+		else
+		if (high == 0x08 && item->id == 0x09) // DETUNE (2byte, 4bit).
+			field.codec = XGParamField::Detune;
+		else
+			field.codec = XGParamField::Value;
+		fields[count++] = field;
+		// Second element (USER VOICE)...
+		if (stride > 0 && item->id >= 0x3d) {
+			field.low += stride;
+			fields[count++] = field;
+		}
 	}
-	
-	// XG EFFECT...
+
+	std::sort(fields, fields + count, xgparam_field_less);
+
+	if (count > 0)
+		size = fields[count - 1].low + fields[count - 1].size;
+
+	XGParamLayout layout;
+	layout.count  = count;
+	layout.fields = fields;
+	layout.size   = size;
+	return layout;
+}
+
+// Bulk block layouts in use (built once, released on teardown).
+static XGParamLayout g_param_layouts[5];
+
+static void param_layouts_clear (void)
+{
+	for (int i = 0; i < 5; ++i) {
+		XGParamLayout& layout = g_param_layouts[i];
+		delete [] layout.fields;
+		layout.count  = 0;
+		layout.fields = nullptr;
+		layout.size   = 0;
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// class XGParamArena - XG Parameter bulk object storage.
+//
+
+// Constructor.
+XGParamArena::XGParamArena ( unsigned int chunk )
+	: m_chunk(chunk), m_ptr(nullptr), m_avail(0), m_count(0), m_bytes(0)
+{
+}
+
+
+// Destructor (bulk release).
+XGParamArena::~XGParamArena (void)
+{
+	clear();
+}
+
+
+// Raw object storage (never released individually).
+void *XGParamArena::alloc ( unsigned int size )
+{
+	const unsigned int align = alignof(std::max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+
+	if (size > m_avail) {
+		const unsigned int n = (size > m_chunk ? size : m_chunk);
+		m_ptr = new char [n];
+		m_avail = n;
+		m_chunks.append(m_ptr);
+	}
+
+	void *p = m_ptr;
+	m_ptr += size;
+	m_avail -= size;
+
+	++m_count;
+	m_bytes += size;
+
+	return p;
+}
+
+
+// Bulk release (objects must have been destroyed already).
+void XGParamArena::clear (void)
+{
+	QListIterator<char *> iter(m_chunks);
+	while (iter.hasNext())
+		delete [] iter.next();
+
+	m_chunks.clear();
+
+	m_ptr = nullptr;
+	m_avail = 0;
+	m_count = 0;
+	m_bytes = 0;
+}
+
+
+// Allocation stats.
+unsigned int XGParamArena::count (void) const
+{
+	return m_count;
+}
+
+unsigned int XGParamArena::chunks (void) const
+{
+	return m_chunks.count();
+}
+
+unsigned long XGParamArena::bytes (void) const
+{
+	return m_bytes;
+}
+
+
+//-------------------------------------------------------------------------
+// XG Parameter flat index layout.
+//
+// SYSTEM     0x00 0x00 <id>            128 slots
+// EFFECT     0x02 0x01 <id>            128 slots (REVERB/CHORUS/VARIATION TYPE)
+// REVERB     0x02 0x01 <0x01..0x1f>     32 x REVERB effect type slots
+// CHORUS     0x02 0x01 <0x21..0x3f>     32 x CHORUS effect type slots
+// VARIATION  0x02 0x01 <0x41..0x7f>     64 x VARIATION effect type slots
+// MULTIPART  0x08 <part> <id>           16 x 128 slots
+// DRUMSETUP  0x3n <note> <id>            2 x 128 x 16 slots
+// USERVOICE  0x11 <user> <id>           32 x 224 slots (2 elements)
+//
+#define XGINDEX_SYSTEM     0
+#define XGINDEX_EFFECT    (XGINDEX_SYSTEM    + 0x80)
+#define XGINDEX_REVERB    (XGINDEX_EFFECT    + 0x80)
+#define XGINDEX_CHORUS    (XGINDEX_REVERB    + 0x20 * TSIZE(REVERBEffectTab))
+#define XGINDEX_VARIATION (XGINDEX_CHORUS    + 0x20 * TSIZE(CHORUSEffectTab))
+#define XGINDEX_MULTIPART (XGINDEX_VARIATION + 0x40 * TSIZE(VARIATIONEffectTab))
+#define XGINDEX_DRUMSETUP (XGINDEX_MULTIPART + 0x10 * 0x80)
+#define XGINDEX_USERVOICE (XGINDEX_DRUMSETUP + 0x02 * 0x80 * 0x10)
+#define XGINDEX_SIZE      (XGINDEX_USERVOICE + 0x20 * 0xe0)
+
+// Dirty bitset size (in words).
+#define XGINDEX_WORDS     ((XGINDEX_SIZE + 31) >> 5)
+
+
+//-------------------------------------------------------------------------
+// class XGParamMasterMap - XG Parameter master state database.
+//
+// Pseudo-singleton reference.
+XGParamMasterMap *XGParamMasterMap::g_pParamMasterMap = nullptr;
+
+// Pseudo-singleton accessor (static).
+XGParamMasterMap *XGParamMasterMap::getInstance (void)
+{
+	return g_pParamMasterMap;
+}
+
+
+// Constructor.
+XGParamMasterMap::XGParamMasterMap (void)
+	: m_transaction(0)
+{
+	unsigned short i, j, k;
+
+	// Initialize the randomizer seed...
+	::srand(::time(nullptr));
+
+	// Allocate the flat parameter index...
+	m_index = new XGParam * [XGINDEX_SIZE];
+	::memset(m_index, 0, XGINDEX_SIZE * sizeof(XGParam *));
+
+	// Allocate the value and default planes (bitmap word padded)...
+	m_values = new unsigned short [XGINDEX_WORDS << 5];
+	m_defs   = new unsigned short [XGINDEX_WORDS << 5];
+	::memset(m_values, 0, (XGINDEX_WORDS << 5) * sizeof(unsigned short));
+	::memset(m_defs, 0, (XGINDEX_WORDS << 5) * sizeof(unsigned short));
+
+	// Allocate the transaction dirty bitsets...
+	m_dirty = new unsigned int [XGINDEX_WORDS];
+	m_quiet = new unsigned int [XGINDEX_WORDS];
+	::memset(m_dirty, 0, XGINDEX_WORDS * sizeof(unsigned int));
+	::memset(m_quiet, 0, XGINDEX_WORDS * sizeof(unsigned int));
+
+	// Effect type slot index...
+	::memset(m_etypes, 0xff, sizeof(m_etypes));
+	for (i = 0; i < TSIZE(REVERBEffectTab); ++i) {
+		XGEffectItem *eitem = &REVERBEffectTab[i];
+		m_etypes[0][(eitem->msb << 4) + eitem->lsb] = i;
+	}
+	for (i = 0; i < TSIZE(CHORUSEffectTab); ++i) {
+		XGEffectItem *eitem = &CHORUSEffectTab[i];
+		m_etypes[1][(eitem->msb << 4) + eitem->lsb] = i;
+	}
+	for (i = 0; i < TSIZE(VARIATIONEffectTab); ++i) {
+		XGEffectItem *eitem = &VARIATIONEffectTab[i];
+		m_etypes[2][(eitem->msb << 4) + eitem->lsb] = i;
+	}
+
+	qxgeditProfile::mark("XGParamMasterMap: index");
+
+	// XG SYSTEM...
+	for (i = 0; i < TSIZE(SYSTEMParamTab); ++i) {
+		XGParamItem *item = &SYSTEMParamTab[i];
+		XGParam *param = new (m_arena.alloc(sizeof(XGParam)))
+			XGParam(0x00, 0x00, item->id);
+		XGParamMasterMap::add_param(param);
+		SYSTEM.add_param(param, 0);
+	}
+	
+	qxgeditProfile::mark("XGParamMasterMap: SYSTEM");
+
+	// XG EFFECT...
+	// (effect type params are materialized lazily, see below)
+	::memset(m_eslots, 0, sizeof(m_eslots));
 	for (i = 0; i < TSIZE(EFFECTParamTab); ++i) {
 		XGParamItem *item = &EFFECTParamTab[i];
-		if (item->id > 0x00 && item->id < 0x20) {
-			// REVERB...
-			for (j = 0; j < TSIZE(REVERBEffectTab); ++j) {
-				XGEffectItem  *eitem = &REVERBEffectTab[j];
-				unsigned short etype = (eitem->msb << 7) + eitem->lsb;
-				XGEffectParam *eparam
-					= new XGEffectParam(0x02, 0x01, item->id, etype);
-				XGParamMasterMap::add_param(eparam);
-				REVERB.add_param(eparam, etype);
-			}
-		}
-		else
-		if (item->id > 0x20 && item->id < 0x40) {
-			// CHORUS...
-			for (j = 0; j < TSIZE(CHORUSEffectTab); ++j) {
-				XGEffectItem  *eitem = &CHORUSEffectTab[j];
-				unsigned short etype = (eitem->msb << 7) + eitem->lsb;
-				XGEffectParam *eparam
-					= new XGEffectParam(0x02, 0x01, item->id, etype);
-				XGParamMasterMap::add_param(eparam);
-				CHORUS.add_param(eparam, etype);
-			}
-		}
-		else
-		if (item->id > 0x40 && item->id < 0x80) {
-			// VARIATION...
-			for (j = 0; j < TSIZE(VARIATIONEffectTab); ++j) {
-				XGEffectItem  *eitem = &VARIATIONEffectTab[j];
-				unsigned short etype = (eitem->msb << 7) + eitem->lsb;
-				XGEffectParam *eparam
-					= new XGEffectParam(0x02, 0x01, item->id, etype);
-				XGParamMasterMap::add_param(eparam);
-				VARIATION.add_param(eparam, etype);
-			}
-		}
-		else {
+		if (item->id == 0x00 || item->id == 0x20 || item->id == 0x40) {
 			// REVERB, CHORUS, VARIATION TYPE...
-			XGParam *param = new XGParam(0x02, 0x01, item->id);
+			XGParam *param = new (m_arena.alloc(sizeof(XGParam)))
+				XGParam(0x02, 0x01, item->id);
 			XGParamMasterMap::add_param(param);
 			switch (item->id) {
 			case 0x00:
@@ -4113,30 +4467,38 @@ XGParamMasterMap::XGParamMasterMap (void)
 		}
 	}
 
+	qxgeditProfile::mark("XGParamMasterMap: EFFECT");
+
 	// XG MULTI PART...
 	MULTIPART.set_current_key(0);
 	for (i = 0; i < TSIZE(MULTIPARTParamTab); ++i) {
 		XGParamItem *item = &MULTIPARTParamTab[i];
 		for (j = 0; j < 16; ++j) {
-			XGParam *param = new XGParam(0x08, j, item->id);
+			XGParam *param = new (m_arena.alloc(sizeof(XGParam)))
+				XGParam(0x08, j, item->id);
 			XGParamMasterMap::add_param(param);
 			MULTIPART.add_param(param, j);
 		}
 	}
 
+	qxgeditProfile::mark("XGParamMasterMap: MULTIPART");
+
 	// XG DRUM SETUP...
 	DRUMSETUP.set_current_key(36); // Drums 1, Bass Drum (C1).
 	for (i = 0; i < TSIZE(DRUMSETUPParamTab); ++i) {
 		XGParamItem *item = &DRUMSETUPParamTab[i];
 		for (j = 0; j < 2; ++j) {
 			for (k = 13; k < 85; ++k) {
-				XGParam *param = new XGParam(0x30 + j, k, item->id);
+				XGParam *param = new (m_arena.alloc(sizeof(XGParam)))
+					XGParam(0x30 + j, k, item->id);
 				XGParamMasterMap::add_param(param);
 				DRUMSETUP.add_param(param, (j << 7) + k);
 			}
 		}
 	}
 
+	qxgeditProfile::mark("XGParamMasterMap: DRUMSETUP");
+
 	// QS300 USER VOICE...
 	USERVOICE.set_elements(2);
 	USERVOICE.set_current_key(0); // User 1.
@@ -4147,11 +4509,13 @@ XGParamMasterMap::XGParamMasterMap (void)
 				if (item->id >= 0x3d || j == 0) {
 					unsigned short id = item->id + (j * 0x50);
 					if (item->size > 4) {
-						XGDataParam *param = new XGDataParam(0x11, k, id);
+						XGDataParam *param = new (m_arena.alloc(sizeof(XGDataParam)))
+							XGDataParam(0x11, k, id);
 						XGParamMasterMap::add_param(param);
 						USERVOICE.add_param(param, k);
 					} else {
-						XGParam *param = new XGParam(0x11, k, id);
+						XGParam *param = new (m_arena.alloc(sizeof(XGParam)))
+							XGParam(0x11, k, id);
 						XGParamMasterMap::add_param(param);
 						USERVOICE.add_param(param, k);
 					}
@@ -4160,6 +4524,59 @@ XGParamMasterMap::XGParamMasterMap (void)
 		}
 	}
 
+	qxgeditProfile::mark("XGParamMasterMap: USERVOICE");
+
+	// Flat parameter list (in address order)...
+	for (unsigned int n = 0; n < XGINDEX_SIZE; ++n) {
+		XGParam *param = m_index[n];
+		if (param)
+			m_params.append(param);
+	}
+
+	// Effect type value/default planes (unmaterialized params too)...
+	XGEffectItem *etabs[] = { REVERBEffectTab, CHORUSEffectTab, VARIATIONEffectTab };
+	unsigned short esizes[] = {
+		TSIZE(REVERBEffectTab), TSIZE(CHORUSEffectTab), TSIZE(VARIATIONEffectTab) };
+	for (i = 0; i < TSIZE(EFFECTParamTab); ++i) {
+		XGParamItem *item = &EFFECTParamTab[i];
+		if (item->id == 0x00 || item->id == 0x20 || item->id == 0x40)
+			continue;
+		const unsigned short eclass = (item->id >> 5) > 2 ? 2 : (item->id >> 5);
+		for (j = 0; j < esizes[eclass]; ++j) {
+			XGEffectItem *eitem = &etabs[eclass][j];
+			unsigned short etype = (eitem->msb << 7) + eitem->lsb;
+			const int index = find_index(0x02, 0x01, item->id, etype);
+			if (index >= 0) {
+				// Effect type dependent defaults, straight from tables...
+				unsigned short def = item->def;
+				if (item->name == nullptr && item->min < 3)
+					def = (eitem->defs ? eitem->defs[item->max] : 0);
+				m_defs[index] = m_values[index] = def;
+			}
+		}
+	}
+
+	// Value plane blocks...
+	m_blocks.append(XGINDEX_SYSTEM);
+	m_blocks.append(XGINDEX_EFFECT);
+	m_blocks.append(XGINDEX_REVERB);
+	m_blocks.append(XGINDEX_CHORUS);
+	m_blocks.append(XGINDEX_VARIATION);
+	for (j = 0; j < 16; ++j)
+		m_blocks.append(XGINDEX_MULTIPART + (j << 7));
+	for (j = 0; j < 0x100; ++j)
+		m_blocks.append(XGINDEX_DRUMSETUP + (j << 4));
+	for (j = 0; j < 32; ++j)
+		m_blocks.append(XGINDEX_USERVOICE + (j * 0xe0));
+	m_blocks.append(XGINDEX_SIZE);
+
+	// Current (default) effect type params only...
+	materialize(&REVERB, REVERB.current_key());
+	materialize(&CHORUS, CHORUS.current_key());
+	materialize(&VARIATION, VARIATION.current_key());
+
+	qxgeditProfile::mark("XGParamMasterMap: effect types");
+
 	// REVERB key names...
 	for (i = 0; i < TSIZE(REVERBEffectTab); ++i) {
 		XGEffectItem *item = &REVERBEffectTab[i];
@@ -4202,6 +4619,8 @@ XGParamMasterMap::XGParamMasterMap (void)
 		}
 	}
 
+	qxgeditProfile::mark("XGParamMasterMap: NRPN");
+
 	// Pseudo-singleton set.
 	g_pParamMasterMap = this;
 }
@@ -4213,16 +4632,48 @@ XGParamMasterMap::~XGParamMasterMap (void)
 	// Pseudo-singleton reset.
 	g_pParamMasterMap = nullptr;
 
-	XGParamMasterMap::const_iterator iter = XGParamMasterMap::constBegin();
-	for (; iter != XGParamMasterMap::constEnd(); ++iter)
-		delete iter.value();
+	QListIterator<XGParam *> iter(m_params);
+	while (iter.hasNext()) {
+		XGParam *param = iter.next();
+		switch (param->kind()) {
+		case XGParam::Effect:
+			static_cast<XGEffectParam *> (param)->~XGEffectParam();
+			break;
+		case XGParam::Data:
+			static_cast<XGDataParam *> (param)->~XGDataParam();
+			break;
+		default:
+			param->~XGParam();
+			break;
+		}
+	}
+
+	m_params.clear();
+	m_arena.clear();
+
+	// Descriptor caches (lazy, shared per descriptor entry).
+	param_texts_clear();
+	param_tables_clear();
+	param_layouts_clear();
+
+	delete [] m_quiet;
+	delete [] m_dirty;
+	delete [] m_defs;
+	delete [] m_values;
+	delete [] m_index;
 }
 
 
 // Master append method.
-void XGParamMasterMap::add_param ( XGParam *param )
-{
-	XGParamMasterMap::insert(XGParamKey(param), param);
+void XGParamMasterMap::add_param ( XGParam *param, unsigned short etype )
+{
+	const int index = find_index(
+		param->high(), param->mid(), param->low(), etype);
+	if (index >= 0) {
+		m_index[index] = param;
+		m_defs[index] = param->def();
+		param->set_value_slot(&m_values[index]);
+	}
 }
 
 // Add widget to map.
@@ -4232,49 +4683,106 @@ void XGParamMasterMap::add_param_map ( XGParam *param, XGParamMap *map )
 }
 
 
-// Master map finders.
-XGParam *XGParamMasterMap::find_param (
+// Current effect type of an effect parameter address (0 if none).
+unsigned short XGParamMasterMap::current_etype (
 	unsigned short high, unsigned short mid, unsigned short low ) const
 {
-	unsigned short etype = 0;
-
 	if (high == 0x02 && mid == 0x01) {
 		if (low > 0x00 && low < 0x20)
-			etype = REVERB.current_key();
+			return REVERB.current_key();
 		else
 		if (low > 0x20 && low < 0x40)
-			etype = CHORUS.current_key();
+			return CHORUS.current_key();
 		else
 		if (low > 0x40 && low < 0x80)
-			etype = VARIATION.current_key();
+			return VARIATION.current_key();
+	}
+
+	return 0;
+}
+
+
+// Master map finders (effect type params materialized on demand).
+XGParam *XGParamMasterMap::find_param (
+	unsigned short high, unsigned short mid, unsigned short low )
+{
+	return find_param(XGParamKey(high, mid, low),
+		current_etype(high, mid, low));
+}
+
+
+XGParam *XGParamMasterMap::find_param (
+	const XGParamKey& key, unsigned short etype )
+{
+	const int index = find_index(key.high(), key.mid(), key.low(), etype);
+	if (index < 0)
+		return nullptr;
+
+	// Effect type params are materialized on first access...
+	if (m_index[index] == nullptr && key.high() == 0x02) {
+		const unsigned short low = key.low();
+		if (low < 0x20)
+			materialize(&REVERB, etype);
+		else
+		if (low < 0x40)
+			materialize(&CHORUS, etype);
+		else
+			materialize(&VARIATION, etype);
 	}
 
-	return find_param(XGParamKey(high, mid, low), etype);
+	return m_index[index];
+}
+
+
+// Master map finders (materialized params only; const lookup).
+XGParam *XGParamMasterMap::find_param (
+	unsigned short high, unsigned short mid, unsigned short low ) const
+{
+	return find_param(XGParamKey(high, mid, low),
+		current_etype(high, mid, low));
 }
 
 
 XGParam *XGParamMasterMap::find_param (
 	const XGParamKey& key, unsigned short etype ) const
 {
-	const QList<XGParam *>& list
-		= XGParamMasterMap::values(key);
-	QListIterator<XGParam *> iter(list);
-	while (iter.hasNext()) {
-		XGParam *param = iter.next();
-		if (key.high() == 0x02 &&
-			key.mid()  == 0x01 &&
-			key.low()  != 0x00 &&
-			key.low()  != 0x20 &&
-			key.low()  != 0x40) {
-			XGEffectParam *eparam
-				= static_cast<XGEffectParam *> (param);
-			if (eparam->etype() == etype)
-				return param;
+	const int index = find_index(key.high(), key.mid(), key.low(), etype);
+	return (index < 0 ? nullptr : m_index[index]);
+}
+
+
+// NRPN parameter reverse lookup (part or drumset; false if none).
+bool XGParamMasterMap::nrpn_param ( XGParam *param,
+	unsigned short& key, unsigned short& nrpn )
+{
+	if (param == nullptr)
+		return false;
+
+	const unsigned short high = param->high();
+	const unsigned short mid  = param->mid();
+	const unsigned short low  = param->low();
+
+	for (unsigned short i = 0; i < TSIZE(NRPNParamTab); ++i) {
+		XGRpnParamItem *item = &NRPNParamTab[i];
+		if (item->lo != low)
+			continue;
+		// MULTIPART NRPN map...
+		if (item->hi == 0x08 && high == 0x08 && mid < 16) {
+			key  = mid; // part.
+			nrpn = item->param;
+			return true;
+		}
+		else
+		// DRUMSETUP NRPN map...
+		if (item->hi == 0x30 && (high & 0xfe) == 0x30
+			&& mid >= 13 && mid < 85) {
+			key  = (high & 0x01); // drumset.
+			nrpn = item->param + mid;
+			return true;
 		}
-		else return param;
 	}
 
-	return nullptr;
+	return false;
 }
 
 
@@ -4285,4 +4793,418 @@ XGParamMap *XGParamMasterMap::find_param_map ( XGParam *param ) const
 }
 
 
+// Value and default planes (flat index aligned).
+const unsigned short *XGParamMasterMap::values (void) const
+{
+	return m_values;
+}
+
+const unsigned short *XGParamMasterMap::defs (void) const
+{
+	return m_defs;
+}
+
+
+// Value plane and changed-set bitmap sizes.
+unsigned int XGParamMasterMap::plane_size (void) const
+{
+	return (XGINDEX_WORDS << 5);
+}
+
+unsigned int XGParamMasterMap::plane_words (void) const
+{
+	return XGINDEX_WORDS;
+}
+
+
+// Value plane blocks (block offset, end offset at count).
+unsigned int XGParamMasterMap::plane_blocks (void) const
+{
+	return m_blocks.count() - 1;
+}
+
+unsigned int XGParamMasterMap::plane_block ( unsigned int block ) const
+{
+	return m_blocks.at(block);
+}
+
+
+// Flat parameter index slot accessor (nullptr if none).
+XGParam *XGParamMasterMap::index_param ( unsigned int index ) const
+{
+	return (index < XGINDEX_SIZE ? m_index[index] : nullptr);
+}
+
+
+// Value plane quiet write (no notification, nothing sent).
+void XGParamMasterMap::set_index_value (
+	unsigned int index, unsigned short value )
+{
+	if (index < XGINDEX_SIZE)
+		m_values[index] = value;
+}
+
+
+// Value plane snapshot (a copy; delete [] when done).
+unsigned short *XGParamMasterMap::snapshot_values (void) const
+{
+	unsigned short *values = new unsigned short [XGINDEX_WORDS << 5];
+	::memcpy(values, m_values, (XGINDEX_WORDS << 5) * sizeof(unsigned short));
+	return values;
+}
+
+
+// Changed-set bitmap (against defaults or a value plane snapshot).
+void XGParamMasterMap::diff_values (
+	unsigned int *bitmap, const unsigned short *values ) const
+{
+	const unsigned short *a = m_values;
+	const unsigned short *b = (values ? values : m_defs);
+
+	// 32 slots per bitmap word...
+	for (unsigned int n = 0; n < XGINDEX_WORDS; ++n, a += 32, b += 32) {
+	#if defined(__SSE2__)
+		const __m128i *pa = (const __m128i *) a;
+		const __m128i *pb = (const __m128i *) b;
+		const __m128i e0 = _mm_cmpeq_epi16(
+			_mm_loadu_si128(pa + 0), _mm_loadu_si128(pb + 0));
+		const __m128i e1 = _mm_cmpeq_epi16(
+			_mm_loadu_si128(pa + 1), _mm_loadu_si128(pb + 1));
+		const __m128i e2 = _mm_cmpeq_epi16(
+			_mm_loadu_si128(pa + 2), _mm_loadu_si128(pb + 2));
+		const __m128i e3 = _mm_cmpeq_epi16(
+			_mm_loadu_si128(pa + 3), _mm_loadu_si128(pb + 3));
+		const unsigned int lo = _mm_movemask_epi8(_mm_packs_epi16(e0, e1));
+		const unsigned int hi = _mm_movemask_epi8(_mm_packs_epi16(e2, e3));
+		bitmap[n] = ~(lo | (hi << 16));
+	#else
+		unsigned int bits = 0;
+		for (unsigned int k = 0; k < 32; ++k)
+			bits |= (unsigned int) (a[k] != b[k]) << k;
+		bitmap[n] = bits;
+	#endif
+	}
+}
+
+
+// Changed params (against defaults or a value plane snapshot).
+void XGParamMasterMap::changed_params (
+	Params& params, const unsigned short *values ) const
+{
+	unsigned int *bitmap = new unsigned int [XGINDEX_WORDS];
+	diff_values(bitmap, values);
+
+	for (unsigned int n = 0; n < XGINDEX_WORDS; ++n) {
+		unsigned int bits = bitmap[n];
+		for (unsigned int k = 0; bits; ++k, bits >>= 1) {
+			if (bits & 1) {
+				XGParam *param = m_index[(n << 5) + k];
+				if (param)
+					params.append(param);
+			}
+		}
+	}
+
+	delete [] bitmap;
+}
+
+
+// Bulk block layout (nullptr if not a known block type).
+const XGParamLayout *XGParamMasterMap::layout (
+	unsigned short high, unsigned short mid )
+{
+	int i = 0;
+	if (high == 0x00 && mid == 0x00)
+		i = 0;
+	else
+	if (high == 0x02 && mid == 0x01)
+		i = 1;
+	else
+	if (high == 0x08)
+		i = 2;
+	else
+	if (high == 0x30 || high == 0x31)
+		i = 3;
+	else
+	if (high == 0x11)
+		i = 4;
+	else
+		return nullptr;
+
+	// Built once, from the descriptor tables...
+	XGParamLayout& layout = g_param_layouts[i];
+	if (layout.fields == nullptr) {
+		switch (i) {
+		case 0:
+			layout = xgparam_layout(SYSTEMParamTab, TSIZE(SYSTEMParamTab), 0x00);
+			break;
+		case 1:
+			layout = xgparam_layout(EFFECTParamTab, TSIZE(EFFECTParamTab), 0x02);
+			break;
+		case 2:
+			layout = xgparam_layout(MULTIPARTParamTab, TSIZE(MULTIPARTParamTab), 0x08);
+			break;
+		case 3:
+			layout = xgparam_layout(DRUMSETUPParamTab, TSIZE(DRUMSETUPParamTab), 0x30);
+			break;
+		case 4:
+			layout = xgparam_layout(USERVOICEParamTab, TSIZE(USERVOICEParamTab), 0x11, 0x50);
+			break;
+		}
+	}
+
+	return &layout;
+}
+
+
+// Lazy effect parameter materialization (per effect type).
+void XGParamMasterMap::materialize ( XGParamMap *map, unsigned short etype )
+{
+	unsigned short eclass, id0, id1;
+
+	if (map == &REVERB) {
+		eclass = 0; id0 = 0x00; id1 = 0x20;
+	}
+	else
+	if (map == &CHORUS) {
+		eclass = 1; id0 = 0x20; id1 = 0x40;
+	}
+	else
+	if (map == &VARIATION) {
+		eclass = 2; id0 = 0x40; id1 = 0x80;
+	}
+	else return;
+
+	const int slot = find_etype(eclass, etype);
+	if (slot < 0)
+		return;
+
+	const unsigned int mask = (1U << (slot & 31));
+	unsigned int& eslots = m_eslots[eclass][slot >> 5];
+	if (eslots & mask)
+		return;
+
+	eslots |= mask;
+
+	for (unsigned short i = 0; i < TSIZE(EFFECTParamTab); ++i) {
+		XGParamItem *item = &EFFECTParamTab[i];
+		if (item->id > id0 && item->id < id1) {
+			XGEffectParam *eparam = new (m_arena.alloc(sizeof(XGEffectParam)))
+				XGEffectParam(0x02, 0x01, item->id, etype);
+			XGParamMasterMap::add_param(eparam, etype);
+			map->add_param(eparam, etype);
+			m_params.append(eparam);
+			param_added(eparam);
+		}
+	}
+}
+
+
+// Flat parameter list (materialized only; not ordered).
+const XGParamMasterMap::Params& XGParamMasterMap::params (void) const
+{
+	return m_params;
+}
+
+
+// Parameter and observer object storage.
+XGParamArena& XGParamMasterMap::arena (void)
+{
+	return m_arena;
+}
+
+
+// Batched apply transaction (deferred notifications; nestable).
+void XGParamMasterMap::begin_transaction (void)
+{
+	++m_transaction;
+}
+
+
+void XGParamMasterMap::commit_transaction (void)
+{
+	if (m_transaction < 1 || --m_transaction > 0)
+		return;
+
+	// Key params first: one reset per affected map...
+	XGParamMap *maps[] = { &REVERB, &CHORUS, &VARIATION };
+	for (unsigned short i = 0; i < 3; ++i) {
+		XGParam *param = maps[i]->key_param();
+		const int index = (param ? param_index(param) : -1);
+		if (index < 0)
+			continue;
+		const unsigned int mask = (1U << (index & 31));
+		unsigned int& dirty = m_dirty[index >> 5];
+		if (dirty & mask) {
+			dirty &= ~mask;
+			const bool quiet = (m_quiet[index >> 5] & mask);
+			m_quiet[index >> 5] &= ~mask;
+			param->notify_update(quiet ? master_observer(param) : nullptr);
+		}
+	}
+
+	// Then all the other params, in address order...
+	for (unsigned int n = 0; n < XGINDEX_WORDS; ++n) {
+		unsigned int dirty = m_dirty[n];
+		if (dirty == 0)
+			continue;
+		const unsigned int quiet = m_quiet[n];
+		m_dirty[n] = 0;
+		m_quiet[n] = 0;
+		for (unsigned int k = 0; dirty; ++k, dirty >>= 1) {
+			if ((dirty & 1) == 0)
+				continue;
+			XGParam *param = m_index[(n << 5) + k];
+			if (param == nullptr)
+				continue;
+			const bool q = (quiet & (1U << k));
+			param->notify_update(q ? master_observer(param) : nullptr);
+		}
+	}
+}
+
+
+bool XGParamMasterMap::transaction (void) const
+{
+	return (m_transaction > 0);
+}
+
+
+// Deferred notification hook (true if deferred).
+bool XGParamMasterMap::defer_update ( XGParam *param, XGParamObserver *sender )
+{
+	if (m_transaction < 1)
+		return false;
+
+	// Only the master observer may be a deferred sender...
+	const bool quiet = (sender != nullptr);
+	if (quiet && sender != master_observer(param))
+		return false;
+
+	const int index = param_index(param);
+	if (index < 0 || m_index[index] != param)
+		return false;
+
+	// Quiet only if all deferred updates were so...
+	const unsigned int mask = (1U << (index & 31));
+	if ((m_dirty[index >> 5] & mask) == 0) {
+		m_dirty[index >> 5] |= mask;
+		if (quiet)
+			m_quiet[index >> 5] |= mask;
+		else
+			m_quiet[index >> 5] &= ~mask;
+	}
+	else
+	if (!quiet)
+		m_quiet[index >> 5] &= ~mask;
+
+	return true;
+}
+
+
+// Master observer of a parameter (deferred notification sender).
+XGParamObserver *XGParamMasterMap::master_observer ( XGParam * ) const
+{
+	return nullptr;
+}
+
+
+// Late materialized parameter notification.
+void XGParamMasterMap::param_added ( XGParam * )
+{
+}
+
+
+// Flat parameter index slot finder (-1 if out of range).
+int XGParamMasterMap::find_index (
+	unsigned short high, unsigned short mid, unsigned short low,
+	unsigned short etype ) const
+{
+	int slot;
+
+	switch (high) {
+	case 0x00:
+		// SYSTEM...
+		if (mid == 0x00 && low < 0x80)
+			return XGINDEX_SYSTEM + low;
+		break;
+	case 0x02:
+		// EFFECT...
+		if (mid != 0x01 || low > 0x7f)
+			break;
+		if (low > 0x00 && low < 0x20) {
+			// REVERB...
+			slot = find_etype(0, etype);
+			if (slot >= 0)
+				return XGINDEX_REVERB
+					+ low * TSIZE(REVERBEffectTab) + slot;
+		}
+		else
+		if (low > 0x20 && low < 0x40) {
+			// CHORUS...
+			slot = find_etype(1, etype);
+			if (slot >= 0)
+				return XGINDEX_CHORUS
+					+ (low - 0x20) * TSIZE(CHORUSEffectTab) + slot;
+		}
+		else
+		if (low > 0x40) {
+			// VARIATION...
+			slot = find_etype(2, etype);
+			if (slot >= 0)
+				return XGINDEX_VARIATION
+					+ (low - 0x40) * TSIZE(VARIATIONEffectTab) + slot;
+		}
+		else {
+			// REVERB, CHORUS, VARIATION TYPE...
+			return XGINDEX_EFFECT + low;
+		}
+		break;
+	case 0x08:
+		// MULTI PART...
+		if (mid < 0x10 && low < 0x80)
+			return XGINDEX_MULTIPART + (mid << 7) + low;
+		break;
+	case 0x11:
+		// USER VOICE...
+		if (mid < 0x20 && low < 0xe0)
+			return XGINDEX_USERVOICE + (mid * 0xe0) + low;
+		break;
+	case 0x30:
+	case 0x31:
+		// DRUM SETUP...
+		if (mid < 0x80 && low < 0x10)
+			return XGINDEX_DRUMSETUP + ((high - 0x30) << 11) + (mid << 4) + low;
+		break;
+	}
+
+	return -1;
+}
+
+
+// Flat parameter index slot of a parameter.
+int XGParamMasterMap::param_index ( XGParam *param ) const
+{
+	const unsigned short high = param->high();
+	const unsigned short mid  = param->mid();
+	const unsigned short low  = param->low();
+
+	return find_index(high, mid, low, param->etype());
+}
+
+
+// Effect type slot finder (-1 if none).
+int XGParamMasterMap::find_etype (
+	unsigned short eclass, unsigned short etype ) const
+{
+	const unsigned short msb = (etype >> 7) & 0x7f;
+	const unsigned short lsb = (etype & 0x7f);
+	if (eclass > 2 || lsb > 0x0f)
+		return -1;
+
+	const unsigned char slot = m_etypes[eclass][(msb << 4) + lsb];
+	return (slot < 0xff ? int(slot) : -1);
+}
+
+
 // end of XGParam.cpp
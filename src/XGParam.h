@@ -26,6 +26,7 @@
 
 #include <QHash>
 #include <QMap>
+#include <QList>
 
 
 // Helper prototypes.
@@ -61,6 +62,52 @@ typedef
 struct _XGRpnParamItem XGRpnParamItem;
 
 
+//-------------------------------------------------------------------------
+// XGParamText - Cached textual representations (per descriptor entry).
+//
+
+struct XGParamText
+{
+	QString label;
+	QString text;
+};
+
+
+//-------------------------------------------------------------------------
+// XGParamTable - Display value lookup tables (per descriptor entry).
+//
+
+struct XGParamTable
+{
+	unsigned short min;
+	unsigned short max;
+	float *getv;
+	const char **gets;
+};
+
+
+//-------------------------------------------------------------------------
+// XGParamLayout - XG bulk block layout (per block type).
+//
+
+struct XGParamField
+{
+	// Field data codecs.
+	enum Codec { Value = 0, Detune = 1, Data = 2 };
+
+	unsigned short low;    // field offset (low address).
+	unsigned short size;   // field width in bytes.
+	unsigned short codec;  // field data codec.
+};
+
+struct XGParamLayout
+{
+	unsigned short      count;   // number of fields.
+	const XGParamField *fields;  // fields, offset ordered.
+	unsigned short      size;    // block data size (bytes).
+};
+
+
 //-------------------------------------------------------------------------
 // class XGInstrument - XG Instrument/Normal Voice Group descriptor.
 //
@@ -184,26 +231,34 @@ public:
 	// Constructor.
 	XGParam(unsigned short high, unsigned short mid, unsigned short low);
 
-	// Virtual destructor.
-	virtual ~XGParam();
+	// Destructor.
+	~XGParam();
+
+	// Parameter kind (dispatch tag).
+	enum Kind { Plain = 0, Effect = 1, Data = 2 };
+
+	Kind kind() const;
 
 	// Address acessors.
 	unsigned short high() const;
 	unsigned short mid()  const;
 	unsigned short low()  const;
 
+	// Sub-address accessors (effect type; 0 if none).
+	unsigned short etype() const;
+
 	// Number of bytes needed to encode subject.
 	unsigned short size() const;
 
-	// Virtual accessors.
-	virtual const char *name() const;
-	virtual unsigned short min() const;
-	virtual unsigned short max() const;
-	virtual unsigned short def() const;
-	virtual float getv(unsigned short u) const;
-	virtual unsigned short getu(float v) const;
-	virtual const char *gets(unsigned short u) const;
-	virtual const char *unit() const;
+	// Descriptor accessors.
+	const char *name() const;
+	unsigned short min() const;
+	unsigned short max() const;
+	unsigned short def() const;
+	float getv(unsigned short u) const;
+	unsigned short getu(float v) const;
+	const char *gets(unsigned short u) const;
+	const char *unit() const;
 
 	// Decode param value from raw 7bit data.
 	void set_data_value(unsigned char *data, unsigned short u) const;
@@ -218,8 +273,11 @@ public:
 	void set_value(unsigned short u, XGParamObserver *sender = nullptr);
 	unsigned short value() const;
 
-	// Virtual reset (to default).
-	virtual void reset(XGParamObserver *sender = nullptr);
+	// Value storage relocation (master value plane slot).
+	void set_value_slot(unsigned short *pvalue);
+
+	// Reset (to default).
+	void reset(XGParamObserver *sender = nullptr);
 
 	// Busy flag predicate.
 	bool busy() const;
@@ -249,18 +307,34 @@ protected:
 	// Value randomizer (p = percent from v).
 	void randomize(int u, float p);
 
+	// Textual representations cache (lazy).
+	const XGParamText *param_text() const;
+
 	// Parameter descriptor.
 	const XGParamItem *m_param;
 
-	// Parameter state.
-	unsigned short m_value;
+	// Parameter sub-descriptor (effect type dependent).
+	const XGEffectParamItem *m_eparam;
+
+	// Parameter state (value plane slot).
+	unsigned short *m_value;
+
+	// Parameter sub-type and its default.
+	unsigned short m_etype;
+	unsigned short m_edef;
+
+	// Parameter kind.
+	unsigned char m_kind;
 
 private:
 
-	// Parameter address.
-	unsigned short m_high;
-	unsigned short m_mid;
-	unsigned short m_low;
+	// Parameter state (own storage, until relocated).
+	unsigned short m_value0;
+
+	// Parameter address (8bit wide will do).
+	unsigned char m_high;
+	unsigned char m_mid;
+	unsigned char m_low;
 
 	// Parameter subject/observer stuff;
 	bool m_busy;
@@ -279,27 +353,6 @@ public:
 	// Constructor.
 	XGEffectParam(unsigned short high, unsigned short mid, unsigned short low,
 		unsigned short etype);
-
-	// Sub-address accessors.
-	unsigned short etype() const;
-
-	// Virtual accessors.
-	const char *name() const;
-	unsigned short min() const;
-	unsigned short max() const;
-	unsigned short def() const;
-	float getv(unsigned short u) const;
-	unsigned short getu(float v) const;
-	const char *gets(unsigned short u) const;
-	const char *unit() const;
-
-private:
-
-	// Parameter sub-type.
-	unsigned short m_etype;	
-
-	// Parameter sub-descriptor.
-	const XGEffectParamItem *m_eparam;
 };
 
 
@@ -322,7 +375,7 @@ public:
 		XGParamObserver *sender = nullptr);
 	unsigned char *data() const;
 
-	// Virtual reset (to default).
+	// Data reset (to default).
 	void reset(XGParamObserver *sender = nullptr);
 
 private:
@@ -412,9 +465,21 @@ public:
 	// Param set/factory method.
 	XGParamSet *find_paramset(unsigned short id);
 
+	// Key param span (all params of a key, in id order).
+	typedef QList<XGParam *> Params;
+
+	Params key_params(unsigned short key) const;
+
+	// Lazy param set materialization (effect types).
+	void materialize(unsigned short key);
+
 	// Local observers notify (key change). 
 	void notify_reset();
 
+	// Rebindable observers (re-pointed on key/element change).
+	void bind(XGParamObserver *observer, unsigned short id);
+	void unbind(XGParamObserver *observer);
+
 	// Key/type name stuff.
 	typedef QMap<unsigned short, QString> Keys;
 
@@ -459,6 +524,13 @@ protected:
 
 private:
 
+	// Rebind observer(s) to current key/element param.
+	void rebind(XGParamObserver *observer, unsigned short id);
+	void rebind();
+
+	// Element stride filter (USERVOICE, QS300).
+	bool element_param(XGParam *param) const;
+
 	// Instance variables.
 	XGParam *m_key_param;
 	unsigned short m_key;
@@ -472,6 +544,12 @@ private:
 	// Special element stride settings (USERVOICE, QS300).
 	unsigned short m_elements;
 	unsigned short m_element;
+
+	// Rebindable observers (by param id).
+	QHash<XGParamObserver *, unsigned short> m_bound;
+
+	// Key param span index.
+	QHash<unsigned short, Params> m_key_params;
 };
 
 
@@ -498,7 +576,7 @@ public:
 		if (m_channel != key.channel())
 			return (m_channel < key.channel());
 		else
-			return (m_channel < key.param());
+			return (m_param < key.param());
 	}
 
 private:
@@ -516,11 +594,51 @@ private:
 class XGRpnParamMap : public QMap<XGRpnParamKey, XGParam *> {};
 
 
+//-------------------------------------------------------------------------
+// class XGParamArena - XG Parameter bulk object storage.
+//
+
+class XGParamArena
+{
+public:
+
+	// Constructor.
+	XGParamArena(unsigned int chunk = 0x10000);
+
+	// Destructor (bulk release).
+	~XGParamArena();
+
+	// Raw object storage (never released individually).
+	void *alloc(unsigned int size);
+
+	// Bulk release (objects must have been destroyed already).
+	void clear();
+
+	// Allocation stats.
+	unsigned int count() const;
+	unsigned int chunks() const;
+	unsigned long bytes() const;
+
+private:
+
+	// Instance variables.
+	unsigned int m_chunk;
+
+	char *m_ptr;
+	unsigned int m_avail;
+
+	unsigned int  m_count;
+	unsigned long m_bytes;
+
+	QList<char *> m_chunks;
+};
+
+
 //-------------------------------------------------------------------------
 // class XGParamMaster - XG Parameter master state database.
 //
 
-class XGParamMasterMap : public QMultiMap<XGParamKey, XGParam *>
+class XGParamMasterMap
 {
 public:
 
@@ -528,7 +646,7 @@ public:
 	XGParamMasterMap();
 
 	// Destructor.
-	~XGParamMasterMap();
+	virtual ~XGParamMasterMap();
 
 	// Pseudo-singleton accessor.
 	static XGParamMasterMap *getInstance();
@@ -543,12 +661,22 @@ public:
 	XGParamMap USERVOICE;
 
 	// master append method
-	void add_param(XGParam *param);
+	void add_param(XGParam *param, unsigned short etype = 0);
 
 	// Add widget to map.
 	void add_param_map(XGParam *param, XGParamMap *map);
 
-	// Master map finders.
+	// Master map finders (effect type params materialized on demand).
+	XGParam *find_param(
+		unsigned short high,
+		unsigned short mid,
+		unsigned short low);
+
+	XGParam *find_param(
+		const XGParamKey& key,
+		unsigned short etype = 0);
+
+	// Master map finders (materialized params only; const lookup).
 	XGParam *find_param(
 		unsigned short high,
 		unsigned short mid,
@@ -561,14 +689,126 @@ public:
 	// Find map from param.
 	XGParamMap *find_param_map(XGParam *param) const;
 
+	// Bulk block layout (nullptr if not a known block type).
+	static const XGParamLayout *layout(unsigned short high, unsigned short mid);
+
+	// Lazy effect parameter materialization (per effect type).
+	void materialize(XGParamMap *map, unsigned short etype);
+
+	// Flat parameter list (materialized only; not ordered).
+	typedef QList<XGParam *> Params;
+
+	const Params& params() const;
+
+	// Value and default planes (flat index aligned).
+	const unsigned short *values() const;
+	const unsigned short *defs() const;
+
+	// Value plane and changed-set bitmap sizes.
+	unsigned int plane_size() const;
+	unsigned int plane_words() const;
+
+	// Value plane blocks (SYSTEM, EFFECT, effect classes, parts,
+	// drum notes, user voices; block offset, end offset at count).
+	unsigned int plane_blocks() const;
+	unsigned int plane_block(unsigned int block) const;
+
+	// Flat parameter index slot accessor (nullptr if none).
+	XGParam *index_param(unsigned int index) const;
+
+	// Value plane snapshot (a copy; delete [] when done).
+	unsigned short *snapshot_values() const;
+
+	// Changed-set bitmap (against defaults or a value plane snapshot).
+	void diff_values(unsigned int *bitmap,
+		const unsigned short *values = nullptr) const;
+
+	// Changed params (against defaults or a value plane snapshot).
+	void changed_params(Params& params,
+		const unsigned short *values = nullptr) const;
+
 	// NRPN parameter map.
 	XGRpnParamMap NRPN;
 
+	// NRPN parameter reverse lookup (part or drumset; false if none).
+	static bool nrpn_param(XGParam *param,
+		unsigned short& key, unsigned short& nrpn);
+
+	// Batched apply transaction (deferred notifications; nestable).
+	void begin_transaction();
+	void commit_transaction();
+
+	bool transaction() const;
+
+	// Deferred notification hook (true if deferred).
+	bool defer_update(XGParam *param, XGParamObserver *sender);
+
+	// Master observer of a parameter (deferred notification sender).
+	virtual XGParamObserver *master_observer(XGParam *param) const;
+
+	// Parameter and observer object storage.
+	XGParamArena& arena();
+
+protected:
+
+	// Late materialized parameter notification.
+	virtual void param_added(XGParam *param);
+
+	// Flat parameter index slot of a parameter.
+	int param_index(XGParam *param) const;
+
+	// Value plane quiet write (no notification, nothing sent).
+	void set_index_value(unsigned int index, unsigned short value);
+
+	// Flat parameter index slot finder (-1 if out of range).
+	int find_index(
+		unsigned short high,
+		unsigned short mid,
+		unsigned short low,
+		unsigned short etype = 0) const;
+
+	// Effect type slot finder (-1 if none).
+	int find_etype(unsigned short eclass, unsigned short etype) const;
+
+	// Current effect type of an effect parameter address (0 if none).
+	unsigned short current_etype(
+		unsigned short high,
+		unsigned short mid,
+		unsigned short low) const;
+
 private:
 
+	// Parameter object storage (bulk released on teardown).
+	XGParamArena m_arena;
+
 	// Instance variables.
 	QHash<XGParam *, XGParamMap *> m_params_map;
 
+	// Flat parameter index, direct addressed.
+	XGParam **m_index;
+
+	// Value and default planes (flat index aligned).
+	unsigned short *m_values;
+	unsigned short *m_defs;
+
+	// Value plane block offsets.
+	QList<unsigned int> m_blocks;
+
+	// Flat parameter list (materialized only).
+	Params m_params;
+
+	// Effect type slot index (REVERB, CHORUS, VARIATION; by MSB/LSB).
+	unsigned char m_etypes[3][0x800];
+
+	// Materialized effect type slots bitset (per effect class).
+	unsigned int m_eslots[3][4];
+
+	// Batched apply transaction state (dirty and quiet bitsets).
+	int m_transaction;
+
+	unsigned int *m_dirty;
+	unsigned int *m_quiet;
+
 	// Pseudo-singleton reference.
 	static XGParamMasterMap *g_pParamMasterMap;
 };
@@ -23,23 +23,34 @@
 #include "XGParam.h"
 
 #include <cstdio>
+#include <cstring>
 
 
 //-------------------------------------------------------------------------
 // XG SysEx generic message.
 //
 
-// Constructor
+// Constructor (owned storage).
 XGSysex::XGSysex ( unsigned short size )
-	: m_data(nullptr), m_size(size)
+	: m_data(nullptr), m_size(size), m_owner(size > BuffSize)
+{
+	if (m_owner)
+		m_data = new unsigned char [m_size];
+	else
+		m_data = m_buff;
+}
+
+// Constructor (caller-provided storage).
+XGSysex::XGSysex ( unsigned char *data, unsigned short size )
+	: m_data(data), m_size(size), m_owner(false)
 {
-	m_data = new unsigned char [m_size];
 }
 
 // Destructor
 XGSysex::~XGSysex (void)
 {
-	delete m_data;
+	if (m_owner)
+		delete [] m_data;
 }
 
 
@@ -60,27 +71,140 @@ unsigned short XGSysex::size (void) const
 
 // Constructor.
 XGParamSysex::XGParamSysex ( XGParam *param )
-	: XGSysex(8 + param->size())
+	: XGSysex(size(param))
+{
+	encode(param, m_data);
+}
+
+
+// Message size for a given parameter.
+unsigned short XGParamSysex::size ( XGParam *param )
+{
+	return HeadSize + param->size();
+}
+
+
+// Encoder (caller-provided storage, at least size(param) bytes).
+unsigned short XGParamSysex::encode ( XGParam *param, unsigned char *data )
 {
 	unsigned short i = 0;
 
-	m_data[i++] = 0xf0;	// SysEx status (SOX)
-	m_data[i++] = 0x43;	// Yamaha id.
-	m_data[i++] = 0x10;	// Device no.
-	m_data[i++] = 0x4c;	// XG Model id.
+	data[i++] = 0xf0;	// SysEx status (SOX)
+	data[i++] = 0x43;	// Yamaha id.
+	data[i++] = 0x10;	// Device no.
+	data[i++] = 0x4c;	// XG Model id.
 
-	m_data[i++] = param->high();
-	m_data[i++] = param->mid();
-	m_data[i++] = param->low();
+	data[i++] = param->high();
+	data[i++] = param->mid();
+	data[i++] = param->low();
 
 	if (param->high() == 0x08 && param->low() == 0x09) // DETUNE (2byte,4 bit).
-		param->set_data_value2(&m_data[i], param->value());
+		param->set_data_value2(&data[i], param->value());
 	else
-		param->set_data_value(&m_data[i], param->value());
+		param->set_data_value(&data[i], param->value());
 	i += param->size();
 
 	// Coda...
-	m_data[i] = 0xf7;		// SysEx status (EOX)
+	data[i++] = 0xf7;		// SysEx status (EOX)
+
+	return i;
+}
+
+
+//-------------------------------------------------------------------------
+// XG Native Bulk Dump SysEx message (contiguous parameter run).
+
+// Constructor (address ordered, contiguous parameter run).
+XGParamBulkSysex::XGParamBulkSysex ( XGParam *const *params, unsigned short count )
+	: XGSysex(size(params, count))
+{
+	encode(params, count, m_data);
+}
+
+
+// Message size for a contiguous parameter run.
+unsigned short XGParamBulkSysex::size (
+	XGParam *const *params, unsigned short count )
+{
+	unsigned short n = 0;
+	for (unsigned short i = 0; i < count; ++i)
+		n += params[i]->size();
+
+	return HeadSize + n;
+}
+
+
+// Contiguous parameter run length (address ordered list).
+unsigned short XGParamBulkSysex::run (
+	XGParam *const *params, unsigned short count )
+{
+	if (count < 1)
+		return 0;
+
+	unsigned short n = 1;
+	while (n < count) {
+		XGParam *prev  = params[n - 1];
+		XGParam *param = params[n];
+		// Same block (high, mid)?
+		if (param->high() != prev->high() || param->mid() != prev->mid())
+			break;
+		// Adjacent address?
+		if (param->low() != prev->low() + prev->size())
+			break;
+		++n;
+	}
+
+	return n;
+}
+
+
+// Encoder (caller-provided storage, at least size(params, count) bytes).
+unsigned short XGParamBulkSysex::encode (
+	XGParam *const *params, unsigned short count, unsigned char *data )
+{
+	const unsigned short nsize = size(params, count) - HeadSize;
+
+	unsigned short i = 0;
+
+	data[i++] = 0xf0;	// SysEx status (SOX)
+	data[i++] = 0x43;	// Yamaha id.
+	data[i++] = 0x00;	// Device no.
+	data[i++] = 0x4c;	// XG Model id.
+	data[i++] = (nsize >> 7) & 0x7f;	// Byte count MSB.
+	data[i++] = (nsize & 0x7f);		// Byte count LSB.
+
+	data[i++] = params[0]->high();
+	data[i++] = params[0]->mid();
+	data[i++] = params[0]->low();
+
+	for (unsigned short j = 0; j < count; ++j) {
+		XGParam *param = params[j];
+		if (param->size() > 4) {
+			XGDataParam *dataparam = static_cast<XGDataParam *> (param);
+			::memcpy(&data[i], dataparam->data(), dataparam->size());
+		}
+		else
+		if (param->high() == 0x08 && param->low() == 0x09) { // DETUNE (2byte, 4bit).
+			param->set_data_value2(&data[i], param->value());
+		}
+		else {
+			param->set_data_value(&data[i], param->value());
+		}
+		i += param->size();
+	}
+
+	// Compute checksum...
+	unsigned char cksum = 0;
+	for (unsigned short j = 4; j < i; ++j) {
+		cksum += data[j];
+		cksum &= 0x7f;
+	}
+	data[i++] = (0x80 - cksum) & 0x7f;
+
+	// Coda...
+	data[i++] = 0xf7;		// SysEx status (EOX)
+
+	return i;
 }
 
 
@@ -89,12 +213,27 @@ XGParamSysex::XGParamSysex ( XGParam *param )
 
 // Constructor.
 XGUserVoiceSysex::XGUserVoiceSysex ( unsigned short id )
-	: XGSysex(0x188) // (size = 0x188 = 11 + 0x17d)
+	: XGSysex(Size)
+{
+	encode(id, m_data);
+}
+
+
+// Constructor (caller-provided storage, at least Size bytes).
+XGUserVoiceSysex::XGUserVoiceSysex ( unsigned short id, unsigned char *data )
+	: XGSysex(data, Size)
+{
+	encode(id, m_data);
+}
+
+
+// Encoder (caller-provided storage, at least Size bytes).
+unsigned short XGUserVoiceSysex::encode ( unsigned short id, unsigned char *data )
 {
 	XGParamMasterMap *pMasterMap = XGParamMasterMap::getInstance();
 	if (pMasterMap == nullptr) {
-		::memset(m_data, 0, m_size);
-		return;
+		::memset(data, 0, Size);
+		return Size;
 	}
 
 	unsigned short high = 0x11;
@@ -103,49 +242,56 @@ XGUserVoiceSysex::XGUserVoiceSysex ( unsigned short id )
 
 	unsigned short i = 0;
 
-	m_data[i++] = 0xf0;	// SysEx status (SOX)
-	m_data[i++] = 0x43;	// Yamaha id.
-	m_data[i++] = 0x00;	// Device no.
-	m_data[i++] = 0x4b;	// QS300 Model id.
-	m_data[i++] = 0x02;	// Byte count MSB (= 0x17d >> 7).
-	m_data[i++] = 0x7d;	// Byte count LSB (= 0x17d & 0x7f).
-
-	m_data[i++] = high;
-	m_data[i++] = mid;
-	m_data[i++] = low;
-
-	unsigned short i0 = i;
-	while (i < m_size - 2) {
-		low = i - i0;
+	data[i++] = 0xf0;	// SysEx status (SOX)
+	data[i++] = 0x43;	// Yamaha id.
+	data[i++] = 0x00;	// Device no.
+	data[i++] = 0x4b;	// QS300 Model id.
+	data[i++] = 0x02;	// Byte count MSB (= 0x17d >> 7).
+	data[i++] = 0x7d;	// Byte count LSB (= 0x17d & 0x7f).
+
+	data[i++] = high;
+	data[i++] = mid;
+	data[i++] = low;
+
+	// Single walk over the block field layout (gaps are zero)...
+	const unsigned short i0 = i;
+	::memset(&data[i0], 0, Size - 2 - i0);
+	const XGParamLayout *layout = XGParamMasterMap::layout(high, mid);
+	for (unsigned short j = 0; layout && j < layout->count; ++j) {
+		const XGParamField& field = layout->fields[j];
+		if (i0 + field.low + field.size > Size - 2)
+			break;
+		low = field.low;
 		XGParam *param = pMasterMap->find_param(high, mid, low);
-		if (param) {
-			if (param->size() > 4) {
-				XGDataParam *dataparam = static_cast<XGDataParam *> (param);
-				::memcpy(&m_data[i], dataparam->data(), dataparam->size());
-			}
-			else
-			if (high == 0x08 && low == 0x09) { // DETUNE (2byte, 4bit).
-				param->set_data_value2(&m_data[i], param->value());
-			}
-			else {
-				param->set_data_value(&m_data[i], param->value());
-			}
-			i += param->size();
-		} else {
-			m_data[i++] = 0x00;
+		if (param == nullptr)
+			continue;
+		unsigned char *pdata = &data[i0 + low];
+		switch (field.codec) {
+		case XGParamField::Data:
+			::memcpy(pdata, static_cast<XGDataParam *> (param)->data(), field.size);
+			break;
+		case XGParamField::Detune:
+			param->set_data_value2(pdata, param->value());
+			break;
+		default:
+			param->set_data_value(pdata, param->value());
+			break;
 		}
 	}
+	i = Size - 2;
 
 	// Compute checksum...
 	unsigned char cksum = 0;
 	for (unsigned short j = 4; j < i; ++j) {
-		cksum += m_data[j];
+		cksum += data[j];
 		cksum &= 0x7f;
 	}
-	m_data[i++] = 0x80 - cksum;
+	data[i++] = (0x80 - cksum) & 0x7f;
 
 	// Coda...
-	m_data[i] = 0xf7;		// SysEx status (EOX)
+	data[i++] = 0xf7;		// SysEx status (EOX)
+
+	return i;
 }
 
 
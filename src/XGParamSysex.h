@@ -34,9 +34,15 @@ class XGSysex
 {
 public:
 
-	// Constructor
+	// Inline (fixed-capacity) storage size.
+	static const unsigned short BuffSize = 24;
+
+	// Constructor (owned storage).
 	XGSysex(unsigned short size);
 
+	// Constructor (caller-provided storage).
+	XGSysex(unsigned char *data, unsigned short size);
+
 	// Destructor
 	virtual ~XGSysex();
 
@@ -49,6 +55,16 @@ protected:
 	// Instance variables.
 	unsigned char *m_data;
 	unsigned short m_size;
+	bool           m_owner;
+
+	// Inline storage, used whenever size fits.
+	unsigned char  m_buff[BuffSize];
+
+private:
+
+	// No copy.
+	XGSysex(const XGSysex&);
+	XGSysex& operator= (const XGSysex&);
 };
 
 
@@ -59,8 +75,48 @@ class XGParamSysex : public XGSysex
 {
 public:
 
+	// Fixed-length message size (SOX, id, model, address, EOX).
+	static const unsigned short HeadSize = 8;
+
 	// Constructor.
 	XGParamSysex(XGParam *param);
+
+	// Message size for a given parameter.
+	static unsigned short size(XGParam *param);
+
+	// Encoder (caller-provided storage, at least size(param) bytes).
+	static unsigned short encode(XGParam *param, unsigned char *data);
+
+	// Basic accessors.
+	using XGSysex::size;
+};
+
+
+//-------------------------------------------------------------------------
+// XG Native Bulk Dump SysEx message (contiguous parameter run).
+
+class XGParamBulkSysex : public XGSysex
+{
+public:
+
+	// Fixed-length overhead (SOX, id, model, count, address, cksum, EOX).
+	static const unsigned short HeadSize = 11;
+
+	// Constructor (address ordered, contiguous parameter run).
+	XGParamBulkSysex(XGParam *const *params, unsigned short count);
+
+	// Message size for a contiguous parameter run.
+	static unsigned short size(XGParam *const *params, unsigned short count);
+
+	// Contiguous parameter run length (address ordered list).
+	static unsigned short run(XGParam *const *params, unsigned short count);
+
+	// Encoder (caller-provided storage, at least size(params, count) bytes).
+	static unsigned short encode(
+		XGParam *const *params, unsigned short count, unsigned char *data);
+
+	// Basic accessors.
+	using XGSysex::size;
 };
 
 
@@ -71,8 +127,17 @@ class XGUserVoiceSysex : public XGSysex
 {
 public:
 
+	// Fixed-length message size (= 11 + 0x17d).
+	static const unsigned short Size = 0x188;
+
 	// Constructor.
 	XGUserVoiceSysex(unsigned short id);
+
+	// Constructor (caller-provided storage, at least Size bytes).
+	XGUserVoiceSysex(unsigned short id, unsigned char *data);
+
+	// Encoder (caller-provided storage, at least Size bytes).
+	static unsigned short encode(unsigned short id, unsigned char *data);
 };
 
 
@@ -154,11 +154,12 @@ public:
 
 	// Constructor.
 	XGParamWidget(QWidget *parent = nullptr)
-		: W(parent), m_param_map(nullptr), m_param_id(0) {}
+		: W(parent), m_param_map(nullptr), m_param_id(0),
+			m_observer(nullptr), m_bound(false) {}
 
 	// Virtual destructor.
 	virtual ~XGParamWidget()
-		{ clear_observers(); }
+		{ clear_observer(); }
 
 	// Pure virtual methods.
 	virtual void set_param(XGParam *param, Observer *sender) = 0;
@@ -170,13 +171,12 @@ public:
 	// Setup.
 	void set_param_map(XGParamMap *map, unsigned short id)
 	{
-		clear_observers();
+		clear_observer();
 
 		m_param_map = map;
 		m_param_id  = id;
 
-		XGParamSet *paramset = add_paramset(m_param_id);
-		if (paramset == nullptr)
+		if (m_param_map == nullptr)
 			return;
 
 #ifdef XGPARAM_WIDGET_MAP
@@ -185,23 +185,19 @@ public:
 			pParamWidgetMap->add_widget(this, m_param_map, m_param_id);
 #endif
 
-		unsigned short key = m_param_map->current_key();
-		if (paramset->contains(key)) {
-			XGParam *param = paramset->value(key);
-			if (param)
-				param->notify_reset();
-		}
-		else
-		if (m_param_map->key_param()) {
-			XGParam *param = m_param_map->key_param();
-			m_observers.insert(0, new Observer(param, this));
-			param->notify_reset();
+		// Single observer, re-pointed by the map on key change;
+		// type (key param) widgets just stay put though...
+		XGParam *param = m_param_map->find_param(m_param_id);
+		if (param == nullptr && m_param_map->key_param()) {
+			m_observer = new Observer(m_param_map->key_param(), this);
+		} else {
+			m_observer = new Observer(param, this);
+			m_param_map->bind(m_observer, m_param_id);
+			m_bound = true;
 		}
 
-		for (unsigned short i = 1; i < m_param_map->elements(); ++i) {
-			if (m_param_id >= 0x3d)
-				add_paramset(m_param_id + (i * 0x50));
-		}
+		if (m_observer->param())
+			m_observer->param()->notify_reset();
 	}
 
 	XGParamMap *param_map() const
@@ -211,44 +207,23 @@ public:
 
 	// Observer accessor.
 	Observer *observer() const
-	{
-		if (m_param_map == nullptr)
-			return nullptr;
-
-		unsigned short key = m_param_map->current_key();
-		if (!m_observers.contains(key))
-			return nullptr;
-
-		return static_cast<Observer *> (m_observers.value(key));
-	}
+		{ return m_observer; }
 
 protected:
 
-	// Paramset observers.
-	XGParamSet *add_paramset(unsigned short id)
+	// Observer cleaner.
+	void clear_observer()
 	{
-		if (m_param_map == nullptr)
-			return nullptr;
-
-		XGParamSet *paramset = m_param_map->find_paramset(id);
-		if (paramset == nullptr)
-			return nullptr;
-
-		XGParamSet::const_iterator iter = paramset->constBegin();
-		for (; iter != paramset->constEnd(); ++iter)
-			m_observers.insert(iter.key(), new Observer(iter.value(), this));
+		if (m_observer == nullptr)
+			return;
 
-		return paramset;
-	}
+		// Maps are gone with the master map...
+		if (m_bound && XGParamMasterMap::getInstance())
+			m_param_map->unbind(m_observer);
 
-	// Observers cleaner.
-	void clear_observers()
-	{
-		QHash<unsigned short, XGParamObserver *>::const_iterator iter
-			= m_observers.constBegin();
-		for (; iter != m_observers.constEnd(); ++iter)
-			delete iter.value();
-		m_observers.clear();
+		delete m_observer;
+		m_observer = nullptr;
+		m_bound = false;
 	}
 
 private:
@@ -257,7 +232,8 @@ private:
 	XGParamMap    *m_param_map;
 	unsigned short m_param_id;
 
-	QHash<unsigned short, XGParamObserver *> m_observers;
+	Observer *m_observer;
+	bool      m_bound;
 };
 
 
@@ -26,6 +26,9 @@
 
 #include "qxgeditPaletteForm.h"
 
+#include "qxgeditProfile.h"
+#include "qxgeditBench.h"
+
 #include <QDir>
 
 #include <QStyleFactory>
@@ -34,6 +37,8 @@
 #include <QTranslator>
 #include <QLocale>
 
+#include <cstring>
+
 #ifndef CONFIG_PREFIX
 #define CONFIG_PREFIX	"/usr/local"
 #endif
@@ -453,6 +458,22 @@ void stacktrace ( int signo )
 int main ( int argc, char **argv )
 {
 	Q_INIT_RESOURCE(qxgedit);
+
+	// Micro-benchmarks mode? (headless; no GUI, no MIDI device)...
+	for (int i = 1; i < argc; ++i) {
+		if (::strcmp(argv[i], "--benchmark") == 0) {
+			QCoreApplication bench(argc, argv);
+			return qxgeditBench::run();
+		}
+	}
+
+	// Startup profiling mode? (the earlier the better)...
+	qxgeditProfile *pProfile = nullptr;
+	for (int i = 1; i < argc && !pProfile; ++i) {
+		if (::strcmp(argv[i], "--profile-startup") == 0)
+			pProfile = new qxgeditProfile();
+	}
+
 #ifdef CONFIG_STACKTRACE
 #if defined(__GNUC__) && defined(Q_OS_LINUX)
 	::signal(SIGILL,  stacktrace);
@@ -469,16 +490,19 @@ int main ( int argc, char **argv )
 #endif
 
 	qxgeditApplication app(argc, argv);
+	qxgeditProfile::mark("main: application");
 
 	// Construct default settings; override with command line arguments.
 	qxgeditOptions options;
 	if (!options.parse_args(app.arguments())) {
+		delete pProfile;
 		app.quit();
 		return 1;
 	}
+	qxgeditProfile::mark("main: options");
 
-	// Have another instance running?
-	if (app.setup()) {
+	// Have another instance running? (not when profiling)
+	if (pProfile == nullptr && app.setup()) {
 		app.quit();
 		return 2;
 	}
@@ -498,11 +522,24 @@ int main ( int argc, char **argv )
 	if (qxgeditPaletteForm::namedPalette(
 			&options.settings(), options.sColorTheme, pal))
 		app.setPalette(pal);
+	qxgeditProfile::mark("main: style");
 
 	// Construct, setup and show the main form (a pseudo-singleton).
 	qxgeditMainForm w;
+	qxgeditProfile::mark("main: main form");
 	w.setup(&options);
 	w.show();
+	qxgeditProfile::mark("main: show");
+
+	// Startup profiling mode: report and bail out.
+	// (run with -platform offscreen for a headless run)
+	if (pProfile) {
+		app.processEvents();
+		qxgeditProfile::mark("main: first events");
+		pProfile->report();
+		delete pProfile;
+		return 0;
+	}
 
 	// Settle this one as application main widget...
 	app.setMainWidget(&w);
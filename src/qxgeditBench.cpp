@@ -0,0 +1,420 @@
+// qxgeditBench.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2021, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qxgeditBench.h"
+
+#include "qxgeditProfile.h"
+#include "qxgeditXGMasterMap.h"
+#include "qxgeditMidiRpn.h"
+
+#include "XGParamSysex.h"
+
+#include <QThread>
+#include <QElapsedTimer>
+
+#include <cstdio>
+
+
+//-------------------------------------------------------------------------
+// qxgeditBench - Micro-benchmarks (headless; no GUI, no MIDI device).
+//
+
+// Run all micro-benchmarks and checks, then report
+// (returns non-zero exit status if any check fails).
+int qxgeditBench::run (void)
+{
+	qxgeditProfile profile;
+
+	// Private master map (no main form, no MIDI device)...
+	qxgeditXGMasterMap *pMasterMap = new qxgeditXGMasterMap();
+	qxgeditProfile::mark("bench: master map");
+
+	sweepKeys(pMasterMap);
+	sysexCodec(pMasterMap);
+	sessionPush(pMasterMap);
+	sysexEncode(pMasterMap);
+	footprint(pMasterMap);
+	nrpnSweep(pMasterMap);
+
+	delete pMasterMap;
+
+	// (N)RPN flush deadline check (fails the run if missed)...
+	const bool bRpnFlush = rpnFlush();
+	rpnDecode();
+
+	profile.report();
+
+	return (bRpnFlush ? 0 : 1);
+}
+
+
+// Key switch and effect type sweeps.
+void qxgeditBench::sweepKeys ( qxgeditXGMasterMap *pMasterMap )
+{
+	// Key switch sweeps (all parts, all drum notes)...
+	const unsigned short iPart = pMasterMap->MULTIPART.current_key();
+	for (unsigned short i = 0; i < 16; ++i)
+		pMasterMap->MULTIPART.set_current_key(i);
+	pMasterMap->MULTIPART.set_current_key(iPart);
+	qxgeditProfile::mark("sweep: MULTIPART (16 parts)");
+
+	const unsigned short iDrumKey = pMasterMap->DRUMSETUP.current_key();
+	for (unsigned short j = 0; j < 2; ++j) {
+		for (unsigned short k = 13; k < 85; ++k)
+			pMasterMap->DRUMSETUP.set_current_key((j << 7) + k);
+	}
+	pMasterMap->DRUMSETUP.set_current_key(iDrumKey);
+	qxgeditProfile::mark("sweep: DRUMSETUP (144 notes)");
+
+	// Effect type sweeps (quiet; nothing sent out)...
+	XGParamMap *apEffectMaps[] = {
+		&(pMasterMap->REVERB),
+		&(pMasterMap->CHORUS),
+		&(pMasterMap->VARIATION)
+	};
+	for (XGParamMap *pEffectMap : apEffectMaps) {
+		XGParam *pKeyParam = pEffectMap->key_param();
+		if (pKeyParam == nullptr)
+			continue;
+		XGParamObserver *pSender = pMasterMap->master_observer(pKeyParam);
+		const unsigned short iEType = pKeyParam->value();
+		const XGParamMap::Keys& keys = pEffectMap->keys();
+		XGParamMap::Keys::const_iterator iter = keys.constBegin();
+		const XGParamMap::Keys::const_iterator& iter_end = keys.constEnd();
+		for ( ; iter != iter_end; ++iter)
+			pKeyParam->set_value(iter.key(), pSender);
+		pKeyParam->set_value(iEType, pSender);
+	}
+	qxgeditProfile::mark("sweep: effect types");
+}
+
+
+// Bulk dump encoding and decoding.
+void qxgeditBench::sysexCodec ( qxgeditXGMasterMap *pMasterMap )
+{
+	// Bulk dump decoding (32 user voices, all 16 parts)...
+	qxgeditXGMasterMap::SysexData sysex_data;
+	for (unsigned short iUser = 0; iUser < 32; ++iUser) {
+		XGUserVoiceSysex sysex(iUser);
+		pMasterMap->add_sysex_data(sysex_data, sysex.data(), sysex.size());
+	}
+	qxgeditProfile::mark("encode: USERVOICE (32 dumps)");
+	pMasterMap->set_sysex_data(sysex_data);
+	qxgeditProfile::mark("decode: USERVOICE (32 dumps)");
+
+	sysex_data.clear();
+	qxgeditXGMasterMap::Params params;
+	for (unsigned short iPart = 0; iPart < 16; ++iPart)
+		params.append(pMasterMap->MULTIPART.key_params(iPart));
+	qxgeditXGMasterMap::SysexList sysex_list;
+	pMasterMap->pack_params(params, sysex_list);
+	QListIterator<QByteArray> sysex_iter(sysex_list);
+	while (sysex_iter.hasNext()) {
+		const QByteArray& sysex = sysex_iter.next();
+		pMasterMap->add_sysex_data(sysex_data,
+			(unsigned char *) sysex.constData(), sysex.size());
+	}
+	qxgeditProfile::mark("encode: MULTIPART (16 parts)");
+	pMasterMap->set_sysex_data(sysex_data);
+	qxgeditProfile::mark("decode: MULTIPART (16 parts)");
+}
+
+
+// Full-session push, Native Bulk Dump vs. Parameter Change.
+void qxgeditBench::sessionPush ( qxgeditXGMasterMap *pMasterMap )
+{
+	qxgeditXGMasterMap::Params push_params;
+	QListIterator<XGParam *> push_iter(pMasterMap->params());
+	while (push_iter.hasNext()) {
+		XGParam *pParam = push_iter.next();
+		if (pParam->high() != 0x11 && pParam == pMasterMap->find_param(
+				pParam->high(), pParam->mid(), pParam->low()))
+			push_params.append(pParam);
+	}
+
+	QElapsedTimer push_timer;
+	push_timer.start();
+	qint64 iPushBytes = 0;
+	QListIterator<XGParam *> change_iter(push_params);
+	while (change_iter.hasNext()) {
+		XGParamSysex sysex(change_iter.next());
+		iPushBytes += sysex.size();
+	}
+	qxgeditProfile::count("push: param change (usecs)",
+		push_timer.nsecsElapsed() / 1000);
+	qxgeditProfile::count("push: param change messages", push_params.count());
+	qxgeditProfile::count("push: param change bytes", iPushBytes);
+	qxgeditProfile::count("push: param change DIN wire time (msecs)",
+		(iPushBytes * 1000) / 3125);
+
+	push_timer.restart();
+	qxgeditXGMasterMap::SysexList push_list;
+	pMasterMap->pack_params(push_params, push_list);
+	iPushBytes = 0;
+	QListIterator<QByteArray> push_list_iter(push_list);
+	while (push_list_iter.hasNext())
+		iPushBytes += push_list_iter.next().size();
+	qxgeditProfile::count("push: bulk dump (usecs)",
+		push_timer.nsecsElapsed() / 1000);
+	qxgeditProfile::count("push: bulk dump messages", push_list.count());
+	qxgeditProfile::count("push: bulk dump bytes", iPushBytes);
+	qxgeditProfile::count("push: bulk dump DIN wire time (msecs)",
+		(iPushBytes * 1000) / 3125);
+}
+
+
+// SysEx encoding throughput (per-message heap buffer,
+// as the former XGSysex did, vs. inline/caller storage).
+void qxgeditBench::sysexEncode ( qxgeditXGMasterMap *pMasterMap )
+{
+	XGParam *pVolume = pMasterMap->find_param(0x08, 0x00, 0x0b);
+	if (pVolume == nullptr)
+		return;
+
+	const int iSysexMsgs = 100000;
+	const unsigned short iSysexSize = XGParamSysex::size(pVolume);
+	unsigned int iSysexSum = 0;
+
+	QElapsedTimer sysex_timer;
+	sysex_timer.start();
+	for (int i = 0; i < iSysexMsgs; ++i) {
+		unsigned char *data = new unsigned char [iSysexSize];
+		XGParamSysex::encode(pVolume, data);
+		iSysexSum += data[iSysexSize - 2];
+		delete [] data;
+	}
+	qint64 iSysexNsecs = sysex_timer.nsecsElapsed();
+	if (iSysexNsecs > 0) {
+		qxgeditProfile::count("sysex: param change, heap (msgs/sec)",
+			(qint64(iSysexMsgs) * 1000000000) / iSysexNsecs);
+	}
+
+	sysex_timer.restart();
+	for (int i = 0; i < iSysexMsgs; ++i) {
+		XGParamSysex sysex(pVolume);
+		iSysexSum += sysex.data()[iSysexSize - 2];
+	}
+	iSysexNsecs = sysex_timer.nsecsElapsed();
+	if (iSysexNsecs > 0) {
+		qxgeditProfile::count("sysex: param change, inline (msgs/sec)",
+			(qint64(iSysexMsgs) * 1000000000) / iSysexNsecs);
+	}
+
+	const int iUserMsgs = 1000;
+	sysex_timer.restart();
+	for (int i = 0; i < iUserMsgs; ++i) {
+		unsigned char *data = new unsigned char [XGUserVoiceSysex::Size];
+		XGUserVoiceSysex::encode(i & 0x1f, data);
+		iSysexSum += data[XGUserVoiceSysex::Size - 2];
+		delete [] data;
+	}
+	iSysexNsecs = sysex_timer.nsecsElapsed();
+	if (iSysexNsecs > 0) {
+		qxgeditProfile::count("sysex: user voice, heap (msgs/sec)",
+			(qint64(iUserMsgs) * 1000000000) / iSysexNsecs);
+	}
+
+	sysex_timer.restart();
+	for (int i = 0; i < iUserMsgs; ++i) {
+		unsigned char data[XGUserVoiceSysex::Size];
+		XGUserVoiceSysex::encode(i & 0x1f, data);
+		iSysexSum += data[XGUserVoiceSysex::Size - 2];
+	}
+	iSysexNsecs = sysex_timer.nsecsElapsed();
+	if (iSysexNsecs > 0) {
+		qxgeditProfile::count("sysex: user voice, stack (msgs/sec)",
+			(qint64(iUserMsgs) * 1000000000) / iSysexNsecs);
+	}
+
+	qxgeditProfile::count("sysex: checksum (ignore)", iSysexSum);
+}
+
+
+// Param/observer storage (arena vs. single heap allocations)
+// and per-param footprint (instance sizes, arena bytes per param).
+void qxgeditBench::footprint ( qxgeditXGMasterMap *pMasterMap )
+{
+	const XGParamArena& arena = pMasterMap->arena();
+	qxgeditProfile::count("arena: objects", arena.count());
+	qxgeditProfile::count("arena: heap chunks", arena.chunks());
+	qxgeditProfile::count("arena: bytes", qint64(arena.bytes()));
+
+	const qint64 iParams = pMasterMap->params().count();
+	qxgeditProfile::count("footprint: sizeof(XGParam)", qint64(sizeof(XGParam)));
+	qxgeditProfile::count("footprint: sizeof(XGEffectParam)", qint64(sizeof(XGEffectParam)));
+	qxgeditProfile::count("footprint: sizeof(XGDataParam)", qint64(sizeof(XGDataParam)));
+	qxgeditProfile::count("footprint: params", iParams);
+	if (iParams > 0) {
+		qxgeditProfile::count("footprint: arena bytes/param (incl. observers)",
+			qint64(arena.bytes()) / iParams);
+	}
+}
+
+
+// Filter cutoff sweep (part 1, 128 steps), SysEx bytes vs. NRPN
+// controller events (and those saved by skipping the NRPN select).
+void qxgeditBench::nrpnSweep ( qxgeditXGMasterMap *pMasterMap )
+{
+	XGParam *pCutoff = pMasterMap->find_param(0x08, 0x00, 0x18);
+	if (pCutoff == nullptr)
+		return;
+
+	XGParamSysex sysex(pCutoff);
+	unsigned short nrpn = 0;
+	int ch = pMasterMap->nrpn_channel(pCutoff, nrpn);
+	if (ch < 0)
+		ch = 0;
+
+	qxgeditMidiNrpnEncoder encoder;
+	qxgeditMidiNrpnEncoder::Controller ctls[qxgeditMidiNrpnEncoder::MaxCount];
+	qint64 iNrpnCount = 0;
+	for (unsigned short v = 0; v < 128; ++v)
+		iNrpnCount += encoder.encode(ch, nrpn, v, ctls);
+
+	qxgeditProfile::count("nrpn: filter sweep SysEx bytes",
+		qint64(sysex.size()) * 128);
+	qxgeditProfile::count("nrpn: filter sweep CC events",
+		iNrpnCount);
+	qxgeditProfile::count("nrpn: filter sweep CC events saved",
+		qint64(qxgeditMidiNrpnEncoder::MaxCount) * 128 - iNrpnCount);
+}
+
+
+// (N)RPN flush deadline check (16 channels, 7-bit Data Entry only):
+// half-received items must come out no earlier than the flush window
+// and no later than the window plus some scheduling slack.
+#define QXGEDIT_RPN_FLUSH_WINDOW  10
+#define QXGEDIT_RPN_FLUSH_SLACK   5
+
+bool qxgeditBench::rpnFlush (void)
+{
+	qxgeditMidiRpn xrpn;
+	xrpn.setFlushWindow(QXGEDIT_RPN_FLUSH_WINDOW);
+
+	QElapsedTimer rpn_timer;
+	rpn_timer.start();
+
+	// Feed the synthetic CC streams...
+	for (unsigned short iChannel = 0; iChannel < 16; ++iChannel) {
+		qxgeditMidiRpn::Event event;
+		event.time   = 0;
+		event.port   = 0;
+		event.status = qxgeditMidiRpn::CC | iChannel;
+		event.param  = 0x63; // NRPN MSB
+		event.value  = 0x01;
+		xrpn.process(event);
+		event.param  = 0x62; // NRPN LSB
+		event.value  = iChannel;
+		xrpn.process(event);
+		event.param  = 0x06; // Data Entry MSB
+		event.value  = 0x40;
+		xrpn.process(event);
+	}
+
+	const qint64 iFedNsecs = rpn_timer.nsecsElapsed();
+
+	// Wait for the flush deadlines, as the input thread does...
+	int iFlushed = 0;
+	qint64 iMinNsecs = -1;
+	qint64 iMaxNsecs = 0;
+	while (iFlushed < 16 && rpn_timer.elapsed() < 1000) {
+		const int iTimeout = xrpn.flushTimeout();
+		if (iTimeout > 0)
+			QThread::msleep(iTimeout);
+		xrpn.flushExpired();
+		qxgeditMidiRpn::Event event;
+		while (xrpn.dequeue(event)) {
+			const qint64 iNsecs = rpn_timer.nsecsElapsed();
+			if (iMinNsecs < 0 || iNsecs < iMinNsecs)
+				iMinNsecs = iNsecs;
+			if (iMaxNsecs < iNsecs)
+				iMaxNsecs = iNsecs;
+			++iFlushed;
+		}
+	}
+
+	qxgeditProfile::count("rpn: items flushed", iFlushed);
+	qxgeditProfile::count("rpn: flush latency min (us)", iMinNsecs / 1000);
+	qxgeditProfile::count("rpn: flush latency max (us)", iMaxNsecs / 1000);
+
+	// Check whether all deadlines were met (item stamps
+	// are of millisecond resolution, hence the earliest)...
+	const qint64 iEarliest = qint64(QXGEDIT_RPN_FLUSH_WINDOW - 1) * 1000000;
+	const qint64 iLatest = iFedNsecs
+		+ qint64(QXGEDIT_RPN_FLUSH_WINDOW + QXGEDIT_RPN_FLUSH_SLACK) * 1000000;
+	const bool bResult = (iFlushed == 16
+		&& iMinNsecs >= iEarliest && iMaxNsecs <= iLatest);
+	if (!bResult) {
+		fprintf(stderr, "qxgeditBench: (N)RPN flush deadline missed"
+			" (%d/16 items flushed, %.3f..%.3f ms, window %d ms).\n",
+			iFlushed, double(iMinNsecs) / 1000000.0,
+			double(iMaxNsecs) / 1000000.0, QXGEDIT_RPN_FLUSH_WINDOW);
+	}
+
+	qxgeditProfile::count("rpn: flush deadline check (1=ok)", bResult ? 1 : 0);
+
+	return bResult;
+}
+
+
+// (N)RPN decoding throughput (dense 14-bit NRPN, 16 channels).
+void qxgeditBench::rpnDecode (void)
+{
+	qxgeditMidiRpn xrpn;
+
+	const int iRpnEvents = 4 * 16 * 16384;
+	int iRpnDecoded = 0;
+
+	QElapsedTimer rpn_timer;
+	rpn_timer.start();
+	for (int i = 0; i < iRpnEvents; i += 4) {
+		qxgeditMidiRpn::Event event;
+		event.time   = 0;
+		event.port   = 0;
+		event.status = qxgeditMidiRpn::CC | ((i >> 2) & 0x0f);
+		event.param  = 0x63; // NRPN MSB
+		event.value  = (i >> 6) & 0x7f;
+		xrpn.process(event);
+		event.param  = 0x62; // NRPN LSB
+		event.value  = (i >> 2) & 0x7f;
+		xrpn.process(event);
+		event.param  = 0x06; // Data Entry MSB
+		event.value  = (i >> 9) & 0x7f;
+		xrpn.process(event);
+		event.param  = 0x26; // Data Entry LSB
+		event.value  = i & 0x7f;
+		xrpn.process(event);
+		while (xrpn.dequeue(event))
+			++iRpnDecoded;
+	}
+
+	const qint64 iRpnNsecs = rpn_timer.nsecsElapsed();
+	if (iRpnNsecs > 0) {
+		qxgeditProfile::count("rpn: dense NRPN (events/sec)",
+			(qint64(iRpnEvents) * 1000000000) / iRpnNsecs);
+	}
+
+	qxgeditProfile::count("rpn: items decoded", iRpnDecoded);
+	qxgeditProfile::count("rpn: items dropped", xrpn.dropCount());
+}
+
+
+// end of qxgeditBench.cpp
@@ -0,0 +1,76 @@
+// qxgeditBench.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2021, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qxgeditBench_h
+#define __qxgeditBench_h
+
+
+// Forward declarations.
+class qxgeditXGMasterMap;
+
+
+//-------------------------------------------------------------------------
+// qxgeditBench - Micro-benchmarks (headless; no GUI, no MIDI device).
+//
+// Runs on a private master map instance, without the main form and
+// without any ALSA sequencer client, so nothing is ever sent out and
+// no live editing state is touched; results are reported through the
+// startup phase profiler (timing marks and named counters).
+
+class qxgeditBench
+{
+public:
+
+	// Run all micro-benchmarks and checks, then report
+	// (returns non-zero exit status if any check fails).
+	static int run();
+
+protected:
+
+	// Key switch and effect type sweeps.
+	static void sweepKeys(qxgeditXGMasterMap *pMasterMap);
+
+	// Bulk dump encoding and decoding.
+	static void sysexCodec(qxgeditXGMasterMap *pMasterMap);
+
+	// Full-session push, Native Bulk Dump vs. Parameter Change.
+	static void sessionPush(qxgeditXGMasterMap *pMasterMap);
+
+	// SysEx encoding throughput (heap vs. inline/stack storage).
+	static void sysexEncode(qxgeditXGMasterMap *pMasterMap);
+
+	// Param/observer storage and per-param footprint.
+	static void footprint(qxgeditXGMasterMap *pMasterMap);
+
+	// Filter cutoff sweep, SysEx vs. NRPN output.
+	static void nrpnSweep(qxgeditXGMasterMap *pMasterMap);
+
+	// (N)RPN flush deadline check (false if missed).
+	static bool rpnFlush();
+
+	// (N)RPN decoding throughput.
+	static void rpnDecode();
+};
+
+
+#endif	// __qxgeditBench_h
+
+// end of qxgeditBench.h
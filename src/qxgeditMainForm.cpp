@@ -25,6 +25,7 @@
 #include "qxgeditOptions.h"
 
 #include "qxgeditXGMasterMap.h"
+#include "qxgeditXGDumpRequest.h"
 #include "qxgeditMidiDevice.h"
 
 #include "XGParamSysex.h"
@@ -35,6 +36,8 @@
 #include "qxgeditOptionsForm.h"
 #include "qxgeditPaletteForm.h"
 
+#include "qxgeditProfile.h"
+
 #include <QApplication>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -114,6 +117,7 @@ qxgeditMainForm::qxgeditMainForm ( QWidget *pParent )
 	m_pOptions = nullptr;
 	m_pMidiDevice = nullptr;
 	m_pMasterMap = nullptr;
+	m_pDumpRequest = nullptr;
 
 	// We'll start clean.
 	m_iUntitled   = 0;
@@ -223,6 +227,22 @@ qxgeditMainForm::qxgeditMainForm ( QWidget *pParent )
 		SIGNAL(triggered(bool)),
 		SLOT(fileExit()));
 
+	QObject::connect(m_ui.editUndoAction,
+		SIGNAL(triggered(bool)),
+		SLOT(editUndo()));
+	QObject::connect(m_ui.editRedoAction,
+		SIGNAL(triggered(bool)),
+		SLOT(editRedo()));
+	QObject::connect(m_ui.editSnapshotAction,
+		SIGNAL(triggered(bool)),
+		SLOT(editSnapshot()));
+	QObject::connect(m_ui.editRecallAction,
+		SIGNAL(triggered(bool)),
+		SLOT(editRecall()));
+	QObject::connect(m_ui.editReadbackAction,
+		SIGNAL(triggered(bool)),
+		SLOT(editReadback()));
+
 	QObject::connect(m_ui.viewMenubarAction,
 		SIGNAL(triggered(bool)),
 		SLOT(viewMenubar(bool)));
@@ -270,6 +290,8 @@ qxgeditMainForm::~qxgeditMainForm (void)
 #endif
 
 	// Free designated devices.
+	if (m_pDumpRequest)
+		delete m_pDumpRequest;
 	if (m_pMidiDevice)
 		delete m_pMidiDevice;
 	if (m_pMasterMap)
@@ -308,27 +330,48 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 
 	// Primary startup stabilization...
 	updateRecentFilesMenu();
+	qxgeditProfile::mark("setup: options");
 
 	// XG master database...
 	m_pMasterMap = new qxgeditXGMasterMap();
 	m_pMasterMap->set_auto_send(m_pOptions->bUservoiceAutoSend);
+	m_pMasterMap->set_nrpn_output(m_pOptions->bMidiNrpnOutput);
+	qxgeditProfile::mark("setup: master map");
 
 	// Start proper devices...
 	m_pMidiDevice = new qxgeditMidiDevice(QXGEDIT_TITLE);
+	m_pMidiDevice->setOutputRate(m_pOptions->iMidiOutputRate);
+	m_pMidiDevice->setRpnFlushWindow(m_pOptions->iMidiRpnFlushWindow);
+	qxgeditProfile::mark("setup: MIDI device");
+
+	// Device state readback engine...
+	m_pDumpRequest = new qxgeditXGDumpRequest(this);
+	m_pDumpRequest->setWindow(m_pOptions->iMidiDumpRequestWindow);
+	m_pDumpRequest->setTimeout(m_pOptions->iMidiDumpRequestTimeout);
+	QObject::connect(m_pDumpRequest,
+		SIGNAL(progress(int, int)),
+		SLOT(readbackProgress(int, int)));
+	QObject::connect(m_pDumpRequest,
+		SIGNAL(finished()),
+		SLOT(readbackFinished()));
 
 	QObject::connect(m_pMidiDevice,
 		SIGNAL(receiveSysex(const QByteArray&)),
-		SLOT(sysexReceived(const QByteArray&)));
+		SLOT(sysexReceived(const QByteArray&)),
+		Qt::DirectConnection);
 	QObject::connect(m_pMidiDevice,
 		SIGNAL(receiveRpn(unsigned char, unsigned short, unsigned short)),
-		SLOT(rpnReceived(unsigned char, unsigned short, unsigned short)));
+		SLOT(rpnReceived(unsigned char, unsigned short, unsigned short)),
+		Qt::DirectConnection);
 	QObject::connect(m_pMidiDevice,
 		SIGNAL(receiveNrpn(unsigned char, unsigned short, unsigned short)),
-		SLOT(nrpnReceived(unsigned char, unsigned short, unsigned short)));
+		SLOT(nrpnReceived(unsigned char, unsigned short, unsigned short)),
+		Qt::DirectConnection);
 
 	// And respective connections...
 	m_pMidiDevice->connectInputs(m_pOptions->midiInputs);
 	m_pMidiDevice->connectOutputs(m_pOptions->midiOutputs);
+	qxgeditProfile::mark("setup: MIDI connections");
 
 	// Change to last known session dir...
 	if (!m_pOptions->sSessionDir.isEmpty())
@@ -357,6 +400,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.MasterVolumeDial          -> set_param_map(SYSTEM, 0x04);
 	m_ui.MasterTransposeDial       -> set_param_map(SYSTEM, 0x06);
 
+	qxgeditProfile::mark("setup: SYSTEM widgets");
+
 	// REVERB...
 	QObject::connect(m_ui.ReverbResetButton,
 		SIGNAL(clicked()),
@@ -383,6 +428,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.ReverbParam15Dial         -> set_param_map(REVERB, 0x14);
 	m_ui.ReverbParam16Dial         -> set_param_map(REVERB, 0x15);
 
+	qxgeditProfile::mark("setup: REVERB widgets");
+
 	// CHORUS...
 	QObject::connect(m_ui.ChorusResetButton,
 		SIGNAL(clicked()),
@@ -410,6 +457,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.ChorusParam15Dial         -> set_param_map(CHORUS, 0x34);
 	m_ui.ChorusParam16Dial         -> set_param_map(CHORUS, 0x35);
 
+	qxgeditProfile::mark("setup: CHORUS widgets");
+
 	// VARIATION...
 	QObject::connect(m_ui.VariationResetButton,
 		SIGNAL(clicked()),
@@ -445,6 +494,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.VariationParam15Dial      -> set_param_map(VARIATION, 0x74);
 	m_ui.VariationParam16Dial      -> set_param_map(VARIATION, 0x75);
 
+	qxgeditProfile::mark("setup: VARIATION widgets");
+
 	// MULTIPART...
 	m_ui.MultipartCombo->setMaxVisibleItems(16);
 	m_ui.MultipartCombo->clear();
@@ -705,6 +756,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.MultipartVelLowDial       -> set_param_map(MULTIPART, 0x6d);
 	m_ui.MultipartVelHighDial      -> set_param_map(MULTIPART, 0x6e);
 
+	qxgeditProfile::mark("setup: MULTIPART widgets");
+
 	// DRUMSETUP...
 	m_ui.DrumsetupCombo->clear();
 	for (int iDrumset = 0; iDrumset < 2; ++iDrumset)
@@ -790,6 +843,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.DrumsetupDecay1Dial       -> set_param_map(DRUMSETUP, 0x0e);
 	m_ui.DrumsetupDecay2Dial       -> set_param_map(DRUMSETUP, 0x0f);
 
+	qxgeditProfile::mark("setup: DRUMSETUP widgets");
+
 	// USERVOICE...
 	m_ui.UservoiceCombo->setMaxVisibleItems(16);
 	m_ui.UservoiceCombo->clear();
@@ -1187,6 +1242,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 	m_ui.UservoiceAEGOffsetDial    -> set_param_map(USERVOICE, 0x8a);
 	m_ui.UservoiceAEGResonanceDial -> set_param_map(USERVOICE, 0x8c);
 
+	qxgeditProfile::mark("setup: USERVOICE widgets");
+
 	// Make sure there's nothing pending...
 	m_pMasterMap->reset_part_dirty();
 	m_pMasterMap->reset_user_dirty();
@@ -1202,6 +1259,8 @@ void qxgeditMainForm::setup ( qxgeditOptions *pOptions )
 		newSession();
 	}
 
+	qxgeditProfile::mark("setup: session");
+
 	// Make it ready :-)
 	statusBar()->showMessage(tr("Ready"), 3000);
 }
@@ -1327,18 +1386,101 @@ void qxgeditMainForm::nrpnReceived (
 void qxgeditMainForm::sysexReceived ( const QByteArray& sysex )
 {
 	if (m_pMasterMap) {
+		unsigned char *data = (unsigned char *) sysex.data();
+		const unsigned short len = (unsigned short) sysex.length();
 		qxgeditXGMasterMap::SysexData sysex_data;
-		m_pMasterMap->add_sysex_data(sysex_data,
-			(unsigned char *) sysex.data(),
-			(unsigned short) sysex.length());
+		// Valid (checksummed) messages only count as dump replies...
+		if (m_pMasterMap->add_sysex_data(sysex_data, data, len)
+			&& m_pDumpRequest)
+			m_pDumpRequest->received(data, len);
 		m_pMasterMap->set_sysex_data(sysex_data);
 	}
 }
 
 
+// Device state readback progress.
+void qxgeditMainForm::readbackProgress ( int iDone, int iTotal )
+{
+	statusBar()->showMessage(
+		tr("Readback: %1 of %2 blocks...").arg(iDone).arg(iTotal));
+}
+
+
+// Device state readback completion.
+void qxgeditMainForm::readbackFinished (void)
+{
+	if (m_pDumpRequest == nullptr)
+		return;
+
+	const int iFailCount = m_pDumpRequest->failCount();
+	if (iFailCount > 0) {
+		showMessage(tr("Readback: %1 of %2 blocks, %3 not replied.")
+			.arg(m_pDumpRequest->replyCount())
+			.arg(m_pDumpRequest->totalCount())
+			.arg(iFailCount));
+	} else {
+		showMessage(tr("Readback: %1 blocks in %2 msecs.")
+			.arg(m_pDumpRequest->replyCount())
+			.arg(m_pDumpRequest->elapsed()));
+	}
+
+	stabilizeForm();
+}
+
+
 //-------------------------------------------------------------------------
 // qxgeditMainForm -- Session file stuff.
 
+// Scan raw SysEx (F0...F7) frames, straight into master map.
+static int qxgedit_scan_sysex ( qxgeditXGMasterMap *pMasterMap,
+	qxgeditXGMasterMap::SysexData& sysex_data,
+	unsigned char *pData, unsigned long iData, unsigned long *piScan = nullptr )
+{
+	int iSysex = 0;
+
+	unsigned char *pEnd = pData + iData;
+	unsigned char *pScan = pData;
+	while (pScan < pEnd) {
+		// Find frame start (SOX)...
+		unsigned char *pSox
+			= (unsigned char *) ::memchr(pScan, 0xf0, pEnd - pScan);
+		if (pSox == nullptr) {
+			pScan = pEnd;
+			break;
+		}
+		// Find frame end (EOX)...
+		unsigned char *pEox
+			= (unsigned char *) ::memchr(pSox + 1, 0xf7, pEnd - pSox - 1);
+		if (pEox == nullptr) {
+			pScan = pSox; // Incomplete frame.
+			break;
+		}
+		// Skip any truncated frames (nested SOX)...
+		unsigned char *pNext;
+		while ((pNext = (unsigned char *) ::memchr(
+				pSox + 1, 0xf0, pEox - pSox - 1)) != nullptr)
+			pSox = pNext;
+		// Got a frame...
+		const unsigned long iLen = (pEox - pSox) + 1;
+		if (iLen < 0x10000) {
+			pMasterMap->add_sysex_data(sysex_data, pSox, iLen);
+			++iSysex;
+		}
+		// Apply in bounded chunks (constant memory)...
+		if (sysex_data.count() >= 1024) {
+			pMasterMap->set_sysex_data(sysex_data, true);
+			sysex_data.clear();
+		}
+		pScan = pEox + 1;
+	}
+
+	if (piScan)
+		*piScan = (pScan - pData);
+
+	return iSysex;
+}
+
+
 // Format the displayable session filename.
 QString qxgeditMainForm::sessionName ( const QString& sFilename )
 {
@@ -1540,45 +1682,53 @@ bool qxgeditMainForm::loadSessionFile ( const QString& sFilename )
 	masterReset();
 
 	int iSysex = 0;
-	unsigned short iBuff = 0;
-	unsigned char *pBuff = nullptr;
-	unsigned short i = 0;
 
-	// Read the file....
+	// Read the file (deferred notifications)....
 	qxgeditXGMasterMap::SysexData sysex_data;
 
-	while (!file.atEnd()) {
-		// (Re)allocate buffer...
-		if (i >= iBuff) {
-			unsigned char *pTemp = pBuff;
-			iBuff += 1024;
-			pBuff  = new unsigned char [iBuff];
-			if (pTemp) {
-				::memcpy(pBuff, pTemp, i);
-				delete [] pTemp;
-			}
-		}
-		// Read the next chunk...
-		unsigned short iRead = file.read((char *) pBuff + i, iBuff - i) + i;
-		while (i < iRead) {
-			if (pBuff[i++] == 0xf7) {
-				++iSysex;
-				m_pMasterMap->add_sysex_data(sysex_data, pBuff, i);
-				if (i < iRead) {
-					::memmove(pBuff, pBuff + i, iRead -= i);
-					i = 0;
-				}
+	m_pMasterMap->begin_transaction();
+
+	const qint64 iSize = file.size();
+	uchar *pMap = (iSize > 0
+		? file.map(0, iSize, QFileDevice::MapPrivateOption) : nullptr);
+	if (pMap) {
+		// Memory-mapped, zero-copy scan...
+		iSysex += qxgedit_scan_sysex(m_pMasterMap,
+			sysex_data, pMap, (unsigned long) iSize);
+		file.unmap(pMap);
+	} else {
+		// Streaming, fixed-window scan...
+		const qint64 iWindow = 0x10000;
+		unsigned char *pBuff = new unsigned char [iWindow];
+		qint64 iData = 0;
+		while (!file.atEnd()) {
+			const qint64 iRead = file.read((char *) pBuff + iData, iWindow - iData);
+			if (iRead <= 0)
+				break;
+			iData += iRead;
+			unsigned long iScan = 0;
+			iSysex += qxgedit_scan_sysex(m_pMasterMap,
+				sysex_data, pBuff, iData, &iScan);
+			// Keep any incomplete frame tail...
+			if (iScan < (unsigned long) iData) {
+				if (iScan == 0 && iData >= iWindow)
+					iScan = iData; // Oversized frame, discard.
+				iData -= iScan;
+				::memmove(pBuff, pBuff + iScan, iData);
+			} else {
+				iData = 0;
 			}
 		}
+		delete [] pBuff;
 	}
 
-	// Cleanup...
-	if (pBuff)
-		delete [] pBuff;	
 	file.close();
 
-	// Notify!
+	// Notify! (feedback packed as bulk dumps)
+	m_pMasterMap->begin_bulk();
 	m_pMasterMap->set_sysex_data(sysex_data, (iSysex > 0));
+	m_pMasterMap->commit_transaction();
+	m_pMasterMap->end_bulk();
 
 	// Deferred QS300 Bulk Dump feedback...
 	for (unsigned short iUser = 0; iUser < 32; ++iUser) {
@@ -1596,6 +1746,9 @@ bool qxgeditMainForm::loadSessionFile ( const QString& sFilename )
 		}
 	}
 
+	// Nothing to undo from a fresh load...
+	m_pMasterMap->clear_journal();
+
 	// We're formerly done.
 	QApplication::restoreOverrideCursor();
 
@@ -1625,16 +1778,25 @@ bool qxgeditMainForm::saveSessionFile ( const QString& sFilename )
 	// Tell the world we'll take some time...
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-	// XG Parameter changes...
-	XGParamMasterMap::const_iterator iter = m_pMasterMap->constBegin();
-	for (; iter != m_pMasterMap->constEnd(); ++iter) {
-		XGParam *pParam = iter.value();
-		if (pParam->high() == 0x11 || pParam->value() == pParam->def())
-			continue;
-		XGParamSysex sysex(pParam);
-		file.write((const char *) sysex.data(), sysex.size());
+	// XG Parameter changes (packed as bulk dumps)...
+	XGParamMasterMap::Params changes;
+	m_pMasterMap->changed_params(changes);
+
+	XGParamMasterMap::Params params;
+	QListIterator<XGParam *> iter(changes);
+	while (iter.hasNext()) {
+		XGParam *pParam = iter.next();
+		if (pParam->high() != 0x11)
+			params.append(pParam);
 	}
 
+	qxgeditXGMasterMap::SysexList sysex_list;
+	m_pMasterMap->pack_params(params, sysex_list);
+
+	QListIterator<QByteArray> sysex_iter(sysex_list);
+	while (sysex_iter.hasNext())
+		file.write(sysex_iter.next());
+
 	// (QS300) USER VOICE Bulk Dumps, whether dirty...
 	for (unsigned short iUser = 0; iUser < 32; ++iUser) {
 		if (m_pMasterMap->user_dirty(iUser)) {
@@ -1723,6 +1885,68 @@ void qxgeditMainForm::fileExit (void)
 }
 
 
+//-------------------------------------------------------------------------
+// qxgeditMainForm -- Edit Action slots.
+
+// Undo last parameter edit(s).
+void qxgeditMainForm::editUndo (void)
+{
+	if (m_pMasterMap && m_pMasterMap->undo())
+		stabilizeForm();
+}
+
+
+// Redo last undone parameter edit(s).
+void qxgeditMainForm::editRedo (void)
+{
+	if (m_pMasterMap && m_pMasterMap->redo())
+		stabilizeForm();
+}
+
+
+// Take a snapshot of the current parameter values.
+void qxgeditMainForm::editSnapshot (void)
+{
+	if (m_pMasterMap == nullptr)
+		return;
+
+	m_pMasterMap->take_snapshot(m_snapshot);
+
+	showMessage(tr("Snapshot taken."));
+
+	stabilizeForm();
+}
+
+
+// Recall the last taken snapshot (sends the changes only).
+void qxgeditMainForm::editRecall (void)
+{
+	if (m_pMasterMap == nullptr || m_snapshot.isEmpty())
+		return;
+
+	const int nparams = m_pMasterMap->recall_snapshot(m_snapshot);
+
+	showMessage(tr("Snapshot recalled (%1 parameters changed).").arg(nparams));
+
+	stabilizeForm();
+}
+
+
+// Read back the current state from the device.
+void qxgeditMainForm::editReadback (void)
+{
+	if (m_pDumpRequest == nullptr)
+		return;
+
+	if (m_pDumpRequest->isActive())
+		m_pDumpRequest->stop();
+	else
+		m_pDumpRequest->start();
+
+	stabilizeForm();
+}
+
+
 //-------------------------------------------------------------------------
 // qxgeditMainForm -- View Action slots.
 
@@ -1879,6 +2103,17 @@ void qxgeditMainForm::viewOptions (void)
 					QApplication::setPalette(pal);
 			}
 		}
+		// MIDI options may be set up immediately...
+		if (m_pMasterMap)
+			m_pMasterMap->set_nrpn_output(m_pOptions->bMidiNrpnOutput);
+		if (m_pMidiDevice) {
+			m_pMidiDevice->setOutputRate(m_pOptions->iMidiOutputRate);
+			m_pMidiDevice->setRpnFlushWindow(m_pOptions->iMidiRpnFlushWindow);
+		}
+		if (m_pDumpRequest) {
+			m_pDumpRequest->setWindow(m_pOptions->iMidiDumpRequestWindow);
+			m_pDumpRequest->setTimeout(m_pOptions->iMidiDumpRequestTimeout);
+		}
 		// Show restart message if needed...
 		if (iOldBaseFontSize != m_pOptions->iBaseFontSize)
 			++iNeedRestart;
@@ -1959,6 +2194,18 @@ void qxgeditMainForm::stabilizeForm (void)
 	// Update the main menu state...
 	m_ui.fileSaveAction->setEnabled(m_iDirtyCount > 0);
 
+	// Undo/redo edit menu.
+	m_ui.editUndoAction->setEnabled(m_pMasterMap && m_pMasterMap->can_undo());
+	m_ui.editRedoAction->setEnabled(m_pMasterMap && m_pMasterMap->can_redo());
+
+	// Snapshot edit menu.
+	m_ui.editSnapshotAction->setEnabled(m_pMasterMap != nullptr);
+	m_ui.editRecallAction->setEnabled(m_pMasterMap && !m_snapshot.isEmpty());
+
+	// Device readback edit menu.
+	m_ui.editReadbackAction->setChecked(
+		m_pDumpRequest && m_pDumpRequest->isActive());
+
 	// Randomize view menu.
 	m_ui.viewRandomizeAction->setEnabled(isRandomizable());
 
@@ -24,11 +24,15 @@
 
 #include "ui_qxgeditMainForm.h"
 
+#include <QVector>
+#include <QByteArray>
+
 
 // Forward declarations...
 class qxgeditOptions;
 class qxgeditMidiDevice;
 class qxgeditXGMasterMap;
+class qxgeditXGDumpRequest;
 
 class QSocketNotifier;
 class QTreeWidget;
@@ -71,6 +75,12 @@ protected slots:
 	void fileSaveAs();
 	void fileExit();
 
+	void editUndo();
+	void editRedo();
+	void editSnapshot();
+	void editRecall();
+	void editReadback();
+
 	void viewMenubar(bool bOn);
 	void viewStatusbar(bool bOn);
 	void viewToolbar(bool bOn);
@@ -115,6 +125,9 @@ protected slots:
 	void nrpnReceived(unsigned char, unsigned short, unsigned short);
 	void sysexReceived(const QByteArray&);
 
+	void readbackProgress(int, int);
+	void readbackFinished();
+
 	void handle_sigusr1();
 	void handle_sigterm();
 
@@ -150,6 +163,11 @@ private:
 	qxgeditMidiDevice  *m_pMidiDevice;
 	qxgeditXGMasterMap *m_pMasterMap;
 
+	qxgeditXGDumpRequest *m_pDumpRequest;
+
+	// Last taken parameter values snapshot.
+	QVector<QByteArray> m_snapshot;
+
 	QSocketNotifier *m_pSigusr1Notifier;
 	QSocketNotifier *m_pSigtermNotifier;
 
@@ -25,9 +25,20 @@
 #include "qxgeditMidiRpn.h"
 
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QAtomicInt>
 #include <QApplication>
 
 #include <cstdio>
+#include <cstring>
+
+
+// Input queue wakeup event type.
+static const QEvent::Type QXGEDIT_MIDI_INPUT_EVENT
+	= QEvent::Type(QEvent::registerEventType());
 
 
 //----------------------------------------------------------------------
@@ -99,6 +110,290 @@ public:
 };
 
 
+//----------------------------------------------------------------------
+// class qxgeditMidiInputSysex -- MIDI SysEx input reassembler.
+//
+// ALSA delivers long SysEx messages (eg. bulk dumps) split in several
+// fragments; these get reassembled in a per-source buffer (input thread
+// only) and only complete F0..F7 frames are let through.
+
+class qxgeditMidiInputSysex
+{
+public:
+
+	// Number of concurrent sources and per-source frame size cap (bytes).
+	static const unsigned int MaxSources = 4;
+	static const unsigned int MaxSize    = 64 * 1024;
+
+	// Constructor (all storage preallocated, at input thread setup).
+	qxgeditMidiInputSysex() : m_iDropCount(0)
+	{
+		m_pData = new unsigned char [MaxSources * MaxSize];
+		for (unsigned int i = 0; i < MaxSources; ++i) {
+			Buffer& buffer = m_buffers[i];
+			buffer.key  = 0;
+			buffer.data = m_pData + i * MaxSize;
+			buffer.size = 0;
+		}
+	}
+
+	// Destructor.
+	~qxgeditMidiInputSysex()
+	{
+		delete [] m_pData;
+	}
+
+	// Reassembler: returns the event to capture, if any (nullptr
+	// while a frame is still partial, or was dropped); never
+	// allocates: frames overflowing the preallocated buffers,
+	// or from too many concurrent sources, are just dropped.
+	snd_seq_event_t *process ( snd_seq_event_t *ev )
+	{
+		if (ev->type != SND_SEQ_EVENT_SYSEX)
+			return ev;
+
+		const unsigned char *data = (const unsigned char *) ev->data.ext.ptr;
+		const unsigned int len = ev->data.ext.len;
+		if (data == nullptr || len < 1)
+			return nullptr;
+
+		const unsigned int key
+			= 0x10000 | (ev->source.client << 8) | ev->source.port;
+		Buffer *pBuffer = findBuffer(key);
+
+		const bool bStart = (data[0] == 0xf0);
+		const bool bEnd   = (data[len - 1] == 0xf7);
+
+		// Complete frame, most common case: pass thru...
+		if (bStart && bEnd) {
+			if (pBuffer)
+				pBuffer->size = 0;
+			return ev;
+		}
+
+		if (pBuffer == nullptr) {
+			if (!bStart) // Orphan fragment.
+				return nullptr;
+			pBuffer = idleBuffer();
+			if (pBuffer == nullptr) {
+				// Too many concurrent sources...
+				++m_iDropCount;
+				return nullptr;
+			}
+			pBuffer->key  = key;
+			pBuffer->size = 0;
+		}
+
+		if (bStart) {
+			// New frame (any partial one is lost)...
+			if (pBuffer->size > 0)
+				++m_iDropCount;
+			pBuffer->size = 0;
+		}
+		else
+		if (pBuffer->size == 0) // Orphan fragment.
+			return nullptr;
+
+		const unsigned int size = pBuffer->size + len;
+		if (size > MaxSize) {
+			// Way too long, drop it...
+			pBuffer->size = 0;
+			++m_iDropCount;
+			return nullptr;
+		}
+
+		::memcpy(pBuffer->data + pBuffer->size, data, len);
+		pBuffer->size = size;
+
+		if (!bEnd)
+			return nullptr;
+
+		// Complete frame, reassembled...
+		m_event = *ev;
+		m_event.data.ext.ptr = pBuffer->data;
+		m_event.data.ext.len = size;
+		pBuffer->size = 0;
+
+		return &m_event;
+	}
+
+	// Incomplete/oversized frame statistics.
+	unsigned int dropCount() const
+		{ return m_iDropCount; }
+
+private:
+
+	// Per-source reassembly buffer (key=0 when never used).
+	struct Buffer
+	{
+		unsigned int   key;
+		unsigned char *data;
+		unsigned int   size;
+	};
+
+	// Source buffer lookup (nullptr if none).
+	Buffer *findBuffer(unsigned int key)
+	{
+		for (unsigned int i = 0; i < MaxSources; ++i) {
+			if (m_buffers[i].key == key)
+				return &m_buffers[i];
+		}
+		return nullptr;
+	}
+
+	// Idle buffer lookup, not amid a frame (nullptr if none).
+	Buffer *idleBuffer()
+	{
+		for (unsigned int i = 0; i < MaxSources; ++i) {
+			if (m_buffers[i].size == 0)
+				return &m_buffers[i];
+		}
+		return nullptr;
+	}
+
+	// Instance variables.
+	unsigned char *m_pData;
+	Buffer m_buffers[MaxSources];
+
+	snd_seq_event_t m_event;
+
+	unsigned int m_iDropCount;
+};
+
+
+//----------------------------------------------------------------------
+// class qxgeditMidiInputQueue -- MIDI input event ring (SPSC).
+//
+// Lock-free single-producer (ALSA input thread), single-consumer
+// (GUI thread) ring of captured events; SysEx payloads are copied
+// into a preallocated byte arena, also managed as a ring.
+
+class qxgeditMidiInputQueue
+{
+public:
+
+	// Ring capacities (must be powers of two).
+	static const unsigned int EventCount = 4096;
+	static const unsigned int ArenaSize  = 256 * 1024;
+
+	// Captured event item.
+	struct Event
+	{
+		int            type;
+		unsigned char  channel;
+		unsigned short param;
+		unsigned short value;
+		unsigned int   offset;	// SysEx arena offset.
+		unsigned int   size;	// SysEx length.
+		unsigned int   end;		// SysEx arena release mark.
+	};
+
+	// Constructor.
+	qxgeditMidiInputQueue()
+		: m_iEventRead(0), m_iEventWrite(0),
+			m_iArenaRead(0), m_iArenaWrite(0), m_iDropCount(0)
+	{
+		m_events = new Event [EventCount];
+		m_arena  = new unsigned char [ArenaSize];
+	}
+
+	// Destructor.
+	~qxgeditMidiInputQueue()
+	{
+		delete [] m_arena;
+		delete [] m_events;
+	}
+
+	// Producer side: enqueue a captured event (false if full).
+	bool push(const snd_seq_event_t *pEv)
+	{
+		const unsigned int iRead  = m_iEventRead.loadAcquire();
+		const unsigned int iWrite = m_iEventWrite.load();
+		if (iWrite - iRead >= EventCount) {
+			m_iDropCount.fetchAndAddRelaxed(1);
+			return false;
+		}
+
+		Event& event = m_events[iWrite & (EventCount - 1)];
+		event.type   = pEv->type;
+		event.offset = 0;
+		event.size   = 0;
+		event.end    = 0;
+
+		if (pEv->type == SND_SEQ_EVENT_SYSEX) {
+			const unsigned int iSize = pEv->data.ext.len;
+			const unsigned int iArenaRead = m_iArenaRead.loadAcquire();
+			unsigned int iArenaWrite = m_iArenaWrite;
+			// Must be contiguous: skip the tail end, if short...
+			const unsigned int iOffset = (iArenaWrite & (ArenaSize - 1));
+			if (iOffset + iSize > ArenaSize)
+				iArenaWrite += ArenaSize - iOffset;
+			if (iArenaWrite + iSize - iArenaRead > ArenaSize) {
+				m_iDropCount.fetchAndAddRelaxed(1);
+				return false;
+			}
+			event.offset = (iArenaWrite & (ArenaSize - 1));
+			event.size   = iSize;
+			::memcpy(m_arena + event.offset, pEv->data.ext.ptr, iSize);
+			iArenaWrite += iSize;
+			event.end    = iArenaWrite;
+			m_iArenaWrite = iArenaWrite;
+		} else {
+			event.channel = pEv->data.control.channel;
+			event.param   = pEv->data.control.param;
+			event.value   = pEv->data.control.value;
+		}
+
+		m_iEventWrite.storeRelease(iWrite + 1);
+		return true;
+	}
+
+	// Consumer side: peek at the oldest event (nullptr if empty).
+	const Event *front() const
+	{
+		const unsigned int iRead = m_iEventRead.load();
+		if (iRead == (unsigned int) m_iEventWrite.loadAcquire())
+			return nullptr;
+		return &m_events[iRead & (EventCount - 1)];
+	}
+
+	// Consumer side: SysEx payload accessor.
+	const unsigned char *data(const Event *pEvent) const
+		{ return m_arena + pEvent->offset; }
+
+	// Consumer side: release the oldest event.
+	void pop()
+	{
+		const unsigned int iRead = m_iEventRead.load();
+		const Event& event = m_events[iRead & (EventCount - 1)];
+		if (event.size > 0)
+			m_iArenaRead.storeRelease(event.end);
+		m_iEventRead.storeRelease(iRead + 1);
+	}
+
+	// Overflow statistics.
+	unsigned int dropCount() const
+		{ return m_iDropCount.load(); }
+
+private:
+
+	// Event ring.
+	Event *m_events;
+
+	QAtomicInt m_iEventRead;
+	QAtomicInt m_iEventWrite;
+
+	// SysEx byte arena ring.
+	unsigned char *m_arena;
+
+	QAtomicInt m_iArenaRead;
+	unsigned int m_iArenaWrite;	// Producer only.
+
+	// Overflow statistics.
+	QAtomicInt m_iDropCount;
+};
+
+
 //----------------------------------------------------------------------
 // class qxgeditMidiInputThread -- MIDI input thread (singleton).
 //
@@ -109,7 +404,8 @@ public:
 
 	// Constructor.
 	qxgeditMidiInputThread(qxgeditMidiDevice *pMidiDevice)
-		: QThread(), m_pMidiDevice(pMidiDevice), m_bRunState(false) {}
+		: QThread(), m_pMidiDevice(pMidiDevice), m_bRunState(false),
+			m_iRpnFlushWindow(0) {}
 
 	// Run-state accessors.
 	void setRunState(bool bRunState)
@@ -117,6 +413,12 @@ public:
 	bool runState() const
 		{ return m_bRunState; }
 
+	// (N)RPN flush window accessors (msecs; 0=idle flush only).
+	void setRpnFlushWindow(int iRpnFlushWindow)
+		{ m_iRpnFlushWindow.store(iRpnFlushWindow > 0 ? iRpnFlushWindow : 0); }
+	int rpnFlushWindow() const
+		{ return m_iRpnFlushWindow.load(); }
+
 protected:
 
 	// The main thread executive.
@@ -139,21 +441,38 @@ protected:
 
 		int iPoll = 0;
 		while (m_bRunState && iPoll >= 0) {
-			// Wait for events...
-			iPoll = poll(pfds, nfds, 200);
-			// Timeout?
-			if (iPoll == 0)
+			// Wait for events, or the next (N)RPN flush deadline...
+			xrpn.setFlushWindow(m_iRpnFlushWindow.load());
+			int iTimeout = xrpn.flushTimeout();
+			if (iTimeout < 0 || iTimeout > 200)
+				iTimeout = 200;
+			iPoll = poll(pfds, nfds, iTimeout);
+			// Idle timeout? (no flush deadline pending: flush all,
+			// including parameter select only items)...
+			if (iPoll == 0 && xrpn.flushTimeout() < 0)
 				xrpn.flush();
 			while (iPoll > 0) {
 				snd_seq_event_t *pEv = nullptr;
 				snd_seq_event_input(pAlsaSeq, &pEv);
 				// Process input event - ...
 				// - enqueue to input track mapping;
-				if (!xrpn.process(pEv))
-					m_pMidiDevice->capture(pEv);
+				if (!xrpn.process(pEv)) {
+					// - reassemble SysEx fragments...
+					snd_seq_event_t *pCaptureEv = m_sysex.process(pEv);
+					if (pCaptureEv)
+						m_pMidiDevice->capture(pCaptureEv);
+				}
+				// - drain (N)RPN queue (fixed capacity)...
+				while (xrpn.isPending()) {
+					snd_seq_event_t ev;
+					if (xrpn.dequeue(&ev))
+						m_pMidiDevice->capture(&ev);
+				}
 			//	snd_seq_free_event(pEv);
 				iPoll = snd_seq_event_input_pending(pAlsaSeq, 0);
 			}
+			// Flush half-received items past their deadline...
+			xrpn.flushExpired();
 			// Process pending events...
 			while (xrpn.isPending()) {
 				snd_seq_event_t ev;
@@ -161,15 +480,501 @@ protected:
 					m_pMidiDevice->capture(&ev);
 			}
 		}
+
+	#ifdef CONFIG_DEBUG
+		fprintf(stderr, "qxgeditMidiInputThread: %u SysEx frame(s) dropped.\n",
+			m_sysex.dropCount());
+		fprintf(stderr, "qxgeditMidiInputThread: %u (N)RPN event(s) dropped.\n",
+			xrpn.dropCount());
+	#endif
+	}
+
+private:
+
+	// The thread launcher engine.
+	qxgeditMidiDevice *m_pMidiDevice;
+
+	// Whether the thread is logically running.
+	bool m_bRunState;
+
+	// (N)RPN flush window (msecs).
+	QAtomicInt m_iRpnFlushWindow;
+
+	// SysEx reassembler (preallocated here, not in the thread).
+	qxgeditMidiInputSysex m_sysex;
+};
+
+
+//----------------------------------------------------------------------
+// class qxgeditMidiOutputThread -- MIDI output scheduler thread.
+//
+// Pending SysEx messages addressing the same XG parameter (or bulk
+// block) are coalesced, so that only the latest one gets sent; the
+// output is paced to a given byte rate (eg. 3125 bytes/sec for the
+// standard 31.25 kbit/s MIDI DIN link). NRPN messages are coalesced
+// by channel and parameter number, and only encoded at send time,
+// against the current wire state (running status, NRPN select).
+
+class qxgeditMidiOutputThread : public QThread
+{
+public:
+
+	// Maximum number of pending messages (must be a power of two).
+	static const int MaxQueueDepth = 4096;
+
+	// Inline message storage size, per pending slot (bytes).
+	static const unsigned short SlotBuffSize = 32;
+
+	// Constructor.
+	qxgeditMidiOutputThread(qxgeditMidiDevice *pMidiDevice)
+		: QThread(), m_pMidiDevice(pMidiDevice), m_bRunState(false),
+			m_iOutputRate(0), m_iHead(-1), m_iTail(-1), m_iFree(0),
+			m_iQueueDepth(0), m_iQueueBytes(0), m_iNextTime(0),
+			m_iCoalesceCount(0), m_iDropCount(0), m_iByteCount(0),
+			m_iNrpnCount(0)
+	{
+		// Preallocated slot pool (all free) and key index (all empty)...
+		m_slots = new Slot [MaxQueueDepth];
+		for (int i = 0; i < MaxQueueDepth; ++i) {
+			Slot& slot = m_slots[i];
+			slot.key  = 0;
+			slot.type = Sysex;
+			slot.size = 0;
+			slot.capacity = 0;
+			slot.ext  = nullptr;
+			slot.prev = -1;
+			slot.next = (i < MaxQueueDepth - 1 ? i + 1 : -1);
+		}
+		m_index = new int [IndexSize];
+		for (int i = 0; i < IndexSize; ++i)
+			m_index[i] = -1;
+		m_timer.start();
+	}
+
+	// Destructor.
+	~qxgeditMidiOutputThread()
+	{
+		for (int i = 0; i < MaxQueueDepth; ++i) {
+			if (m_slots[i].ext)
+				delete [] m_slots[i].ext;
+		}
+		delete [] m_index;
+		delete [] m_slots;
+	}
+
+	// Run-state accessors.
+	void setRunState(bool bRunState)
+	{
+		QMutexLocker locker(&m_mutex);
+		m_bRunState = bRunState;
+		m_cond.wakeAll();
+	}
+
+	bool runState() const
+		{ return m_bRunState; }
+
+	// Output pacing rate accessors (bytes/sec; 0=unlimited).
+	void setOutputRate(int iOutputRate)
+	{
+		QMutexLocker locker(&m_mutex);
+		m_iOutputRate = (iOutputRate > 0 ? iOutputRate : 0);
+		m_cond.wakeAll();
+	}
+
+	int outputRate() const
+		{ return m_iOutputRate; }
+
+	// Queue statistics.
+	int queueDepth() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_iQueueDepth;
+	}
+
+	unsigned long coalesceCount() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_iCoalesceCount;
+	}
+
+	unsigned long dropCount() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_iDropCount;
+	}
+
+	unsigned long byteCount() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_iByteCount;
+	}
+
+	// Time to drain all pending messages at the pacing rate
+	// (msecs; 0 when unlimited).
+	int drainTime() const
+	{
+		QMutexLocker locker(&m_mutex);
+		if (m_iOutputRate < 1)
+			return 0;
+		qint64 iDrainTime = (qint64(m_iQueueBytes) * 1000000) / m_iOutputRate;
+		const qint64 iTime = m_timer.nsecsElapsed() / 1000;
+		if (m_iNextTime > iTime)
+			iDrainTime += m_iNextTime - iTime;
+		return int((iDrainTime + 999) / 1000);
+	}
+
+	// Enqueue a SysEx message (coalescing by XG address).
+	void enqueue(unsigned char *pSysex, unsigned short iSysex)
+	{
+		enqueue(Sysex, addressKey(pSysex, iSysex), pSysex, iSysex);
+	}
+
+	// Enqueue a NRPN message (coalescing by channel and number).
+	void enqueueNrpn(
+		unsigned char ch, unsigned short nrpn, unsigned char val)
+	{
+		const unsigned char data[4] = {
+			(unsigned char) (ch & 0x0f),
+			(unsigned char) ((nrpn >> 7) & 0x7f),
+			(unsigned char) (nrpn & 0x7f),
+			(unsigned char) (val & 0x7f)
+		};
+
+		const quint64 key = (quint64(1) << 62)
+			| ((ch & 0x0f) << 14) | (nrpn & 0x3fff);
+
+		enqueue(Nrpn, key, data, 4);
+	}
+
+protected:
+
+	// Pending message types.
+	enum Type { Sysex = 0, Nrpn = 1 };
+
+	// Key index size (open addressing; must be a power of two).
+	static const int IndexSize = MaxQueueDepth << 1;
+
+	// Enqueue a pending message (coalescing by key, if any).
+	void enqueue(Type type, quint64 key,
+		const unsigned char *data, unsigned short size)
+	{
+		QMutexLocker locker(&m_mutex);
+
+		if (key) {
+			const int i = findKey(key);
+			if (i >= 0) {
+				// Superseded: remove old, re-queue as the latest.
+				removeKey(key);
+				unlink(i);
+				release(i);
+				++m_iCoalesceCount;
+			}
+		}
+
+		const int i = m_iFree;
+		if (i < 0) {
+			++m_iDropCount;
+			return;
+		}
+
+		Slot& slot = m_slots[i];
+		m_iFree = slot.next;
+
+		slot.key  = key;
+		slot.type = type;
+		slot.size = size;
+		if (size > SlotBuffSize && size > slot.capacity) {
+			// Oversized (eg. bulk dump) storage: grown once, kept for reuse
+			// (power of two, never short of the whole message size).
+			unsigned int capacity = 512;
+			while (capacity < size)
+				capacity <<= 1;
+			if (slot.ext)
+				delete [] slot.ext;
+			slot.ext = new unsigned char [capacity];
+			slot.capacity = capacity;
+		}
+		::memcpy(slotData(slot), data, size);
+
+		// Append to pending list...
+		slot.prev = m_iTail;
+		slot.next = -1;
+		if (m_iTail >= 0)
+			m_slots[m_iTail].next = i;
+		else
+			m_iHead = i;
+		m_iTail = i;
+		++m_iQueueDepth;
+		m_iQueueBytes += slotBytes(slot);
+
+		if (key)
+			insertKey(key, i);
+
+		m_cond.wakeAll();
+	}
+
+	// Coalescing key: XG Parameter Change or Bulk Dump address
+	// (model id, high, mid, low, bulk byte count); zero when not
+	// coalesceable. Bulk dumps only coalesce with others covering
+	// the very same address span.
+	static quint64 addressKey(unsigned char *pSysex, unsigned short iSysex)
+	{
+		if (iSysex < 9 || pSysex[0] != 0xf0 || pSysex[1] != 0x43)
+			return 0;
+
+		const unsigned char model = pSysex[3];
+		if (model != 0x4c && model != 0x4b)
+			return 0;
+
+		unsigned short i = 4;
+		unsigned short count = 0;
+		if ((pSysex[2] & 0x70) == 0x00) {
+			// Bulk Dump (byte count)...
+			if (iSysex < 11)
+				return 0;
+			count = ((pSysex[4] & 0x7f) << 7) | (pSysex[5] & 0x7f);
+			i += 2;
+		}
+		else
+		if ((pSysex[2] & 0x70) != 0x10) {
+			// Neither Parameter Change...
+			return 0;
+		}
+
+		return (quint64(1) << 63)
+			| (quint64(pSysex[2] & 0x70) << 48)
+			| (quint64(model) << 40)
+			| (quint64(pSysex[i] & 0x7f) << 32)
+			| (quint64(pSysex[i + 1] & 0x7f) << 24)
+			| (quint64(pSysex[i + 2] & 0x7f) << 16)
+			|  quint64(count);
+	}
+
+	// The main thread executive.
+	void run()
+	{
+		m_mutex.lock();
+		m_bRunState = true;
+		while (m_bRunState) {
+			// Wait for pending messages...
+			if (m_iHead < 0) {
+				m_cond.wait(&m_mutex);
+				continue;
+			}
+			// Wait for the output pacing deadline...
+			const qint64 iTime = m_timer.nsecsElapsed() / 1000;
+			if (m_iOutputRate > 0 && m_iNextTime > iTime) {
+				m_cond.wait(&m_mutex, 1 + (m_iNextTime - iTime) / 1000);
+				continue;
+			}
+			// Take the oldest pending message...
+			const int i = dequeue();
+			const unsigned short iSize = encode(m_slots[i]);
+			// Schedule next deadline (usecs)...
+			if (m_iOutputRate > 0) {
+				if (m_iNextTime < iTime)
+					m_iNextTime = iTime;
+				m_iNextTime += (qint64(iSize) * 1000000) / m_iOutputRate;
+			}
+			// Slot is off the list and index: safe while unlocked...
+			m_mutex.unlock();
+			send(m_slots[i], iSize);
+			m_mutex.lock();
+			release(i);
+		}
+		// Flush whatever is still pending...
+		while (m_iHead >= 0) {
+			const int i = dequeue();
+			send(m_slots[i], encode(m_slots[i]));
+			release(i);
+		}
+		m_mutex.unlock();
 	}
 
 private:
 
+	// Pending message slot.
+	struct Slot
+	{
+		quint64        key;
+		Type           type;
+		unsigned short size;
+		unsigned int   capacity;
+		unsigned char *ext;
+		int            prev;
+		int            next;
+		unsigned char  buff[SlotBuffSize];
+	};
+
+	// Slot message storage.
+	static unsigned char *slotData(Slot& slot)
+		{ return (slot.size > SlotBuffSize ? slot.ext : slot.buff); }
+
+	// Controller event size on the wire (bytes).
+	static const unsigned short ControllerBytes = 3;
+
+	// Slot message size on the wire (NRPN: worst case encoding).
+	static unsigned short slotBytes(const Slot& slot)
+	{
+		return (slot.type == Nrpn
+			? qxgeditMidiNrpnEncoder::MaxCount * ControllerBytes : slot.size);
+	}
+
+	// Encode a pending message against the wire state
+	// (returns the actual number of bytes to send).
+	unsigned short encode(Slot& slot)
+	{
+		unsigned short iSize = 0;
+		if (slot.type == Nrpn) {
+			const unsigned char *data = slotData(slot);
+			m_iNrpnCount = m_nrpn.encode(data[0],
+				(data[1] << 7) | data[2], data[3], m_aNrpnCtls);
+			iSize = m_iNrpnCount * ControllerBytes;
+		} else {
+			iSize = slot.size;
+		}
+		m_iByteCount += iSize;
+		return iSize;
+	}
+
+	// Send an encoded message out.
+	void send(Slot& slot, unsigned short iSize)
+	{
+		if (slot.type == Nrpn) {
+			const unsigned char ch = slotData(slot)[0];
+			for (unsigned short i = 0; i < m_iNrpnCount; ++i) {
+				m_pMidiDevice->sendControllerDirect(ch,
+					m_aNrpnCtls[i].param, m_aNrpnCtls[i].value);
+			}
+		} else {
+			m_pMidiDevice->sendSysexDirect(slotData(slot), iSize);
+		}
+	}
+
+	// Take the oldest pending message slot (mutex locked).
+	int dequeue()
+	{
+		const int i = m_iHead;
+		if (m_slots[i].key)
+			removeKey(m_slots[i].key);
+		unlink(i);
+		return i;
+	}
+
+	// Remove a slot from the pending list (mutex locked).
+	void unlink(int i)
+	{
+		Slot& slot = m_slots[i];
+		if (slot.prev >= 0)
+			m_slots[slot.prev].next = slot.next;
+		else
+			m_iHead = slot.next;
+		if (slot.next >= 0)
+			m_slots[slot.next].prev = slot.prev;
+		else
+			m_iTail = slot.prev;
+		--m_iQueueDepth;
+		m_iQueueBytes -= slotBytes(slot);
+	}
+
+	// Return a slot to the free list (mutex locked).
+	void release(int i)
+	{
+		Slot& slot = m_slots[i];
+		slot.key  = 0;
+		slot.prev = -1;
+		slot.next = m_iFree;
+		m_iFree = i;
+	}
+
+	// Key index hash (home position).
+	static int keyHash(quint64 key)
+		{ return int((key * Q_UINT64_C(0x9e3779b97f4a7c15)) >> 51) & (IndexSize - 1); }
+
+	// Key index lookup (slot, or -1 if not pending).
+	int findKey(quint64 key) const
+	{
+		int h = keyHash(key);
+		while (m_index[h] >= 0) {
+			if (m_slots[m_index[h]].key == key)
+				return m_index[h];
+			h = (h + 1) & (IndexSize - 1);
+		}
+		return -1;
+	}
+
+	// Key index insertion (key must not be there yet).
+	void insertKey(quint64 key, int i)
+	{
+		int h = keyHash(key);
+		while (m_index[h] >= 0)
+			h = (h + 1) & (IndexSize - 1);
+		m_index[h] = i;
+	}
+
+	// Key index removal (backward shift deletion).
+	void removeKey(quint64 key)
+	{
+		int h = keyHash(key);
+		while (m_index[h] >= 0 && m_slots[m_index[h]].key != key)
+			h = (h + 1) & (IndexSize - 1);
+		if (m_index[h] < 0)
+			return;
+		int j = h;
+		for (;;) {
+			j = (j + 1) & (IndexSize - 1);
+			if (m_index[j] < 0)
+				break;
+			const int k = keyHash(m_slots[m_index[j]].key);
+			// Move back only if its home is not within (h, j]...
+			if ((j > h && (k <= h || k > j)) || (j < h && (k <= h && k > j))) {
+				m_index[h] = m_index[j];
+				h = j;
+			}
+		}
+		m_index[h] = -1;
+	}
+
 	// The thread launcher engine.
 	qxgeditMidiDevice *m_pMidiDevice;
 
 	// Whether the thread is logically running.
 	bool m_bRunState;
+
+	// Output pacing rate (bytes/sec).
+	int m_iOutputRate;
+
+	// Preallocated slot pool: pending list (FIFO), free list
+	// and open addressing key index.
+	Slot *m_slots;
+	int  *m_index;
+
+	int m_iHead;
+	int m_iTail;
+	int m_iFree;
+
+	int m_iQueueDepth;
+
+	// Pending message bytes (as for the output pacing).
+	unsigned long m_iQueueBytes;
+
+	// Output pacing clock and next output deadline (usecs).
+	QElapsedTimer m_timer;
+	qint64 m_iNextTime;
+
+	// Queue statistics.
+	unsigned long m_iCoalesceCount;
+	unsigned long m_iDropCount;
+	unsigned long m_iByteCount;
+
+	// NRPN wire state encoder and last encoded message.
+	qxgeditMidiNrpnEncoder m_nrpn;
+	qxgeditMidiNrpnEncoder::Controller m_aNrpnCtls[qxgeditMidiNrpnEncoder::MaxCount];
+	unsigned short m_iNrpnCount;
+
+	// Thread synchronization.
+	mutable QMutex m_mutex;
+	QWaitCondition m_cond;
 };
 
 
@@ -181,7 +986,7 @@ qxgeditMidiDevice *qxgeditMidiDevice::g_pMidiDevice = nullptr;
 
 // Constructor.
 qxgeditMidiDevice::qxgeditMidiDevice ( const QString& sClientName )
-	: QObject(nullptr)
+	: QObject(nullptr), m_iInputWakeup(0)
 {
 	// Set pseudo-singleton reference.
 	g_pMidiDevice = this;
@@ -190,7 +995,11 @@ qxgeditMidiDevice::qxgeditMidiDevice ( const QString& sClientName )
 	m_iAlsaClient = -1;
 	m_iAlsaPort   = -1;
 
-	m_pInputThread = nullptr;
+	m_pInputThread  = nullptr;
+	m_pOutputThread = nullptr;
+
+	// Input event ring (drained on GUI thread)...
+	m_pInputQueue = new qxgeditMidiInputQueue();
 
 	// Open new ALSA sequencer client...
 	if (snd_seq_open(&m_pAlsaSeq, "hw", SND_SEQ_OPEN_DUPLEX, 0) >= 0) {
@@ -208,6 +1017,9 @@ qxgeditMidiDevice::qxgeditMidiDevice ( const QString& sClientName )
 		// Create and start our own MIDI input queue thread...
 		m_pInputThread = new qxgeditMidiInputThread(this);
 		m_pInputThread->start(QThread::TimeCriticalPriority);
+		// Create and start our own MIDI output scheduler thread...
+		m_pOutputThread = new qxgeditMidiOutputThread(this);
+		m_pOutputThread->start(QThread::HighPriority);
 	}
 }
 
@@ -217,6 +1029,21 @@ qxgeditMidiDevice::~qxgeditMidiDevice (void)
 	// Reset pseudo-singleton reference.
 	g_pMidiDevice = nullptr;
 
+	// Flush and delete output thread...
+	if (m_pOutputThread) {
+		if (m_pOutputThread->isRunning()) {
+			m_pOutputThread->setRunState(false);
+			m_pOutputThread->wait();
+		}
+	#ifdef CONFIG_DEBUG
+		fprintf(stderr, "qxgeditMidiDevice: output coalesced=%lu dropped=%lu bytes=%lu\n",
+			m_pOutputThread->coalesceCount(), m_pOutputThread->dropCount(),
+			m_pOutputThread->byteCount());
+	#endif
+		delete m_pOutputThread;
+		m_pOutputThread = nullptr;
+	}
+
 	// Last but not least, delete input thread...
 	if (m_pInputThread) {
 		// Try to terminate executive thread,
@@ -230,6 +1057,15 @@ qxgeditMidiDevice::~qxgeditMidiDevice (void)
 		m_pInputThread = nullptr;
 	}
 
+	if (m_pInputQueue) {
+	#ifdef CONFIG_DEBUG
+		fprintf(stderr, "qxgeditMidiDevice: input dropped=%u\n",
+			m_pInputQueue->dropCount());
+	#endif
+		delete m_pInputQueue;
+		m_pInputQueue = nullptr;
+	}
+
 	if (m_pAlsaSeq) {
 		snd_seq_delete_simple_port(m_pAlsaSeq, m_iAlsaPort);
 		m_iAlsaPort   = -1;
@@ -268,7 +1104,7 @@ int qxgeditMidiDevice::alsaPort (void) const
 void qxgeditMidiDevice::capture ( snd_seq_event_t *pEv )
 {
 	// Must be to ourselves...
-	if (pEv->dest.port |= m_iAlsaPort)
+	if (pEv->dest.port != m_iAlsaPort)
 		return;
 
 #ifdef CONFIG_DEBUG
@@ -287,28 +1123,13 @@ void qxgeditMidiDevice::capture ( snd_seq_event_t *pEv )
 	}
 #endif
 
-	// Post SysEx event...
+	// Post to input queue (RPN, NRPN and SysEx only)...
 	switch (pEv->type) {
 	case SND_SEQ_EVENT_REGPARAM:
-		// Post RPN event...
-		emit receiveRpn(
-			pEv->data.control.channel,
-			pEv->data.control.param,
-			pEv->data.control.value);
-		break;
 	case SND_SEQ_EVENT_NONREGPARAM:
-		// Post NRPN event...
-		emit receiveNrpn(
-			pEv->data.control.channel,
-			pEv->data.control.param,
-			pEv->data.control.value);
-		break;
 	case SND_SEQ_EVENT_SYSEX:
-		// Post SysEx event...
-		emit receiveSysex(
-			QByteArray(
-				(const char *) pEv->data.ext.ptr,
-				(int) pEv->data.ext.len));
+		if (m_pInputQueue->push(pEv) && m_iInputWakeup.testAndSetOrdered(0, 1))
+			QCoreApplication::postEvent(this, new QEvent(QXGEDIT_MIDI_INPUT_EVENT));
 		// Fall thru...
 	default:
 		break;
@@ -316,6 +1137,50 @@ void qxgeditMidiDevice::capture ( snd_seq_event_t *pEv )
 }
 
 
+// Input queue drain (GUI thread, batched).
+void qxgeditMidiDevice::customEvent ( QEvent *pEvent )
+{
+	if (pEvent->type() != QXGEDIT_MIDI_INPUT_EVENT)
+		return;
+
+	// Re-arm wakeup before draining...
+	m_iInputWakeup.storeRelease(0);
+
+	const qxgeditMidiInputQueue::Event *pInputEvent;
+	while ((pInputEvent = m_pInputQueue->front()) != nullptr) {
+		switch (pInputEvent->type) {
+		case SND_SEQ_EVENT_REGPARAM:
+			// Post RPN event...
+			emit receiveRpn(
+				pInputEvent->channel,
+				pInputEvent->param,
+				pInputEvent->value);
+			break;
+		case SND_SEQ_EVENT_NONREGPARAM:
+			// Post NRPN event...
+			emit receiveNrpn(
+				pInputEvent->channel,
+				pInputEvent->param,
+				pInputEvent->value);
+			break;
+		case SND_SEQ_EVENT_SYSEX:
+			// Post SysEx event (arena data, no copy): the payload
+			// is only valid for the duration of this (direct) emit,
+			// as it gets recycled on pop(); receivers must be directly
+			// connected and take a deep copy if they need to keep it...
+			emit receiveSysex(
+				QByteArray::fromRawData(
+					(const char *) m_pInputQueue->data(pInputEvent),
+					(int) pInputEvent->size));
+			// Fall thru...
+		default:
+			break;
+		}
+		m_pInputQueue->pop();
+	}
+}
+
+
 void qxgeditMidiDevice::sendSysex ( const QByteArray& sysex ) const
 {
 	sendSysex((unsigned char *) sysex.data(), (unsigned short) sysex.length());
@@ -324,9 +1189,20 @@ void qxgeditMidiDevice::sendSysex ( const QByteArray& sysex ) const
 
 void qxgeditMidiDevice::sendSysex (
 	unsigned char *pSysex, unsigned short iSysex ) const
+{
+	// Schedule through the output thread, if any...
+	if (m_pOutputThread && m_pOutputThread->isRunning())
+		m_pOutputThread->enqueue(pSysex, iSysex);
+	else
+		sendSysexDirect(pSysex, iSysex);
+}
+
+
+void qxgeditMidiDevice::sendSysexDirect (
+	unsigned char *pSysex, unsigned short iSysex ) const
 {
 #ifdef CONFIG_DEBUG
-	fprintf(stderr, "qxgeditMidiDevice::sendSysex(%p, %u)", pSysex, iSysex);
+	fprintf(stderr, "qxgeditMidiDevice::sendSysexDirect(%p, %u)", pSysex, iSysex);
 	fprintf(stderr, " sysex {");
 	for (unsigned short i = 0; i < iSysex; ++i)
 		fprintf(stderr, " %02x", pSysex[i]);
@@ -356,6 +1232,105 @@ void qxgeditMidiDevice::sendSysex (
 }
 
 
+void qxgeditMidiDevice::sendNrpn (
+	unsigned char ch, unsigned short nrpn, unsigned char val ) const
+{
+	// Schedule through the output thread, if any...
+	if (m_pOutputThread && m_pOutputThread->isRunning()) {
+		m_pOutputThread->enqueueNrpn(ch, nrpn, val);
+	} else {
+		qxgeditMidiNrpnEncoder encoder;
+		qxgeditMidiNrpnEncoder::Controller ctls[qxgeditMidiNrpnEncoder::MaxCount];
+		const unsigned short n = encoder.encode(ch, nrpn, val, ctls);
+		for (unsigned short i = 0; i < n; ++i)
+			sendControllerDirect(ch, ctls[i].param, ctls[i].value);
+	}
+}
+
+
+void qxgeditMidiDevice::sendControllerDirect (
+	unsigned char ch, unsigned char param, unsigned char val ) const
+{
+#ifdef CONFIG_DEBUG
+	fprintf(stderr, "qxgeditMidiDevice::sendControllerDirect(%u, %u, %u)\n",
+		ch, param, val);
+#endif
+
+	// Don't do anything else if engine
+	// has not been activated...
+	if (m_pAlsaSeq == nullptr)
+		return;
+
+	// Initialize sequencer event...
+	snd_seq_event_t ev;
+	snd_seq_ev_clear(&ev);
+
+	// Addressing...
+	snd_seq_ev_set_source(&ev, m_iAlsaPort);
+	snd_seq_ev_set_subs(&ev);
+
+	// The event will be direct...
+	snd_seq_ev_set_direct(&ev);
+
+	// Just set CONTROLLER stuff and send it out..
+	snd_seq_ev_set_controller(&ev, ch & 0x0f, param, val);
+	snd_seq_event_output_direct(m_pAlsaSeq, &ev);
+}
+
+
+// MIDI output pacing rate (bytes/sec; 0=unlimited).
+void qxgeditMidiDevice::setOutputRate ( int iOutputRate )
+{
+	if (m_pOutputThread)
+		m_pOutputThread->setOutputRate(iOutputRate);
+}
+
+int qxgeditMidiDevice::outputRate (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->outputRate() : 0);
+}
+
+
+// MIDI (N)RPN input flush window (msecs; 0=idle flush only).
+void qxgeditMidiDevice::setRpnFlushWindow ( int iRpnFlushWindow )
+{
+	if (m_pInputThread)
+		m_pInputThread->setRpnFlushWindow(iRpnFlushWindow);
+}
+
+int qxgeditMidiDevice::rpnFlushWindow (void) const
+{
+	return (m_pInputThread ? m_pInputThread->rpnFlushWindow() : 0);
+}
+
+
+// MIDI output queue statistics.
+int qxgeditMidiDevice::outputQueueDepth (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->queueDepth() : 0);
+}
+
+unsigned long qxgeditMidiDevice::outputCoalesceCount (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->coalesceCount() : 0);
+}
+
+unsigned long qxgeditMidiDevice::outputDropCount (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->dropCount() : 0);
+}
+
+unsigned long qxgeditMidiDevice::outputByteCount (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->byteCount() : 0);
+}
+
+int qxgeditMidiDevice::outputDrainTime (void) const
+{
+	return (m_pOutputThread ? m_pOutputThread->drainTime() : 0);
+}
+
+
 // MIDI Input(readable) / Output(writable) device list.
 static const char *c_pszItemSep = " / ";
 
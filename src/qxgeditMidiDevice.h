@@ -26,12 +26,15 @@
 #include <QEvent>
 #include <QByteArray>
 #include <QStringList>
+#include <QAtomicInt>
 
 #include <alsa/asoundlib.h>
 
 
 // Forward declarations.
+class qxgeditMidiInputQueue;
 class qxgeditMidiInputThread;
+class qxgeditMidiOutputThread;
 
 
 //----------------------------------------------------------------------------
@@ -59,10 +62,37 @@ public:
 	// MIDI event capture method.
 	void capture(snd_seq_event_t *pEv);
 
-	// MIDI SysEx sender.
+	// MIDI SysEx sender (queued).
 	void sendSysex(const QByteArray& sysex) const;
 	void sendSysex(unsigned char *pSysex, unsigned short iSysex) const;
 
+	// MIDI SysEx sender (immediate).
+	void sendSysexDirect(unsigned char *pSysex, unsigned short iSysex) const;
+
+	// MIDI NRPN sender (queued; 7bit value).
+	void sendNrpn(unsigned char ch, unsigned short nrpn, unsigned char val) const;
+
+	// MIDI controller event sender (immediate).
+	void sendControllerDirect(unsigned char ch,
+		unsigned char param, unsigned char val) const;
+
+	// MIDI output pacing rate (bytes/sec; 0=unlimited).
+	void setOutputRate(int iOutputRate);
+	int outputRate() const;
+
+	// MIDI (N)RPN input flush window (msecs; 0=idle flush only).
+	void setRpnFlushWindow(int iRpnFlushWindow);
+	int rpnFlushWindow() const;
+
+	// MIDI output queue statistics.
+	int outputQueueDepth() const;
+	unsigned long outputCoalesceCount() const;
+	unsigned long outputDropCount() const;
+	unsigned long outputByteCount() const;
+
+	// MIDI output queue drain time (msecs; at the pacing rate).
+	int outputDrainTime() const;
+
 	// MIDI Input(readable) / Output(writable) device list
 	QStringList inputs() const
 		{ return deviceList(true); }
@@ -78,12 +108,18 @@ public:
 signals:
 
 	// Received data signal.
+	// Note: receiveSysex() data points into the input queue arena and
+	// is only valid while the signal is being emitted; connect it with
+	// Qt::DirectConnection and deep-copy the data to keep it around.
 	void receiveRpn(unsigned char ch, unsigned short rpn, unsigned short val);
 	void receiveNrpn(unsigned char ch, unsigned short nrpn, unsigned short val);
 	void receiveSysex(const QByteArray& sysex);
 
 protected:
 
+	// Input queue drain (GUI thread).
+	void customEvent(QEvent *pEvent);
+
 	// MIDI device listing.
 	QStringList deviceList(bool bReadable) const;
 
@@ -97,8 +133,13 @@ private:
 	int        m_iAlsaClient;
 	int        m_iAlsaPort;
 
+	// Input event ring and wakeup flag.
+	qxgeditMidiInputQueue *m_pInputQueue;
+	QAtomicInt             m_iInputWakeup;
+
 	// Name says it all.
-	qxgeditMidiInputThread *m_pInputThread;
+	qxgeditMidiInputThread  *m_pInputThread;
+	qxgeditMidiOutputThread *m_pOutputThread;
 
 	// Pseudo-singleton reference.
 	static qxgeditMidiDevice *g_pMidiDevice;
@@ -21,7 +21,10 @@
 
 #include "qxgeditMidiRpn.h"
 
-#include <QHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include <cstring>
 
 
 #define RPN_MSB   0x65
@@ -107,15 +110,16 @@ class xrpn_item
 {
 public:
 
-	xrpn_item() : m_time(0), m_port(0), m_status(0) {}
+	xrpn_item() : m_time(0), m_stamp(0), m_port(0), m_status(0) {}
 
 	xrpn_item ( const xrpn_item& item ) : m_time(item.m_time),
-		m_port(item.m_port), m_status(item.m_status),
+		m_stamp(item.m_stamp), m_port(item.m_port), m_status(item.m_status),
 		m_param(item.m_param), m_value(item.m_value) {}
 
 	void clear()
 	{
 		m_time = 0;
+		m_stamp = 0;
 		m_port = 0;
 		m_status = 0;
 		m_param.clear();
@@ -127,6 +131,11 @@ public:
 	unsigned long time() const
 		{ return m_time; }
 
+	void set_stamp(qint64 stamp)
+		{ m_stamp = stamp; }
+	qint64 stamp() const
+		{ return m_stamp; }
+
 	void set_port(int port)
 		{ m_port = port; }
 	int port() const
@@ -182,6 +191,8 @@ public:
 
 	bool is_any() const
 		{ return m_param.is_any() || m_value.is_any(); }
+	bool is_value_any() const
+		{ return m_value.is_any(); }
 	bool is_ready() const
 		{ return m_param.is_any() && m_value.is_any(); }
 	bool is_7bit() const
@@ -195,68 +206,102 @@ public:
 private:
 
 	unsigned long m_time;
+	qint64        m_stamp;
 	int           m_port;
 	unsigned char m_status;
 	xrpn_data14   m_param;
 	xrpn_data14   m_value;
 };
 
-typedef QHash<unsigned int, xrpn_item> xrpn_cache;
-
 
 //---------------------------------------------------------------------
-// xrpn_queue - decl.
+// xrpn_cache - decl.
 //
-class xrpn_queue
+// Fixed-size (port, channel) state table; preallocated and cache-line
+// aligned, so that the input thread never allocates (ports beyond the
+// table size are folded over).
+
+class xrpn_cache
 {
 public:
 
-	xrpn_queue ( unsigned int size = 0 )
-		: m_size(0), m_mask(0), m_read(0), m_write(0), m_events(0)
-		{ resize(size); }
+	// Table dimensions (must be powers of two).
+	static const unsigned int Ports    = 16;
+	static const unsigned int Channels = 16;
+	static const unsigned int Size     = Ports * Channels;
+
+	xrpn_cache() : m_ports(0)
+		{ ::memset(m_used, 0, sizeof(m_used)); }
 
-	~xrpn_queue () { if (m_events) delete [] m_events; }
-	
-	void resize ( unsigned int size )
+	// Item accessor (marks it in use).
+	xrpn_item& item ( int port, unsigned short channel )
 	{
-		unsigned int new_size = 4; // must be a power-of-2...
-		while (new_size < size)
-			new_size <<= 1;
-		if (new_size > m_size) {
-			const unsigned int old_size = m_size;
-			qxgeditMidiRpn::Event *new_events
-				= new qxgeditMidiRpn::Event [new_size];
-			qxgeditMidiRpn::Event *old_events = m_events;
-			if (old_events) {
-				if (m_write > m_read) {
-					::memcpy(new_events + m_read, old_events + m_read,
-						(m_write - m_read) * sizeof(qxgeditMidiRpn::Event));
-				}
-				else
-				if (m_write < m_read) {
-					::memcpy(new_events + m_read, old_events + m_read,
-						(old_size - m_read) * sizeof(qxgeditMidiRpn::Event));
-					if (m_write > 0) {
-						::memcpy(new_events + old_size, old_events,
-							m_write * sizeof(qxgeditMidiRpn::Event));
-					}
-					m_write += old_size;
-				}
-			}
-			m_size = new_size;
-			m_mask = new_size - 1;
-			m_events = new_events;
-			if (old_events)
-				delete [] old_events;
+		const unsigned int p = (port & (Ports - 1));
+		const unsigned int c = (channel & (Channels - 1));
+		m_used[p] |= (1 << c);
+		m_ports |= (1 << p);
+		return m_items[(p << 4) | c];
+	}
+
+	// Iteration helpers.
+	bool is_empty () const
+		{ return (m_ports == 0); }
+	bool is_used ( unsigned int i ) const
+		{ return (m_used[i >> 4] & (1 << (i & 0x0f))); }
+
+	xrpn_item& at ( unsigned int i )
+		{ return m_items[i]; }
+	const xrpn_item& at ( unsigned int i ) const
+		{ return m_items[i]; }
+
+	void clear ()
+	{
+		for (unsigned int i = 0; i < Size; ++i) {
+			if (is_used(i))
+				m_items[i].clear();
 		}
+		::memset(m_used, 0, sizeof(m_used));
+		m_ports = 0;
 	}
 
-	void clear() { m_read = m_write = 0; }
- 
+private:
+
+	alignas(64) xrpn_item m_items[Size];
+
+	unsigned short m_used[Ports];
+	unsigned short m_ports;
+};
+
+
+//---------------------------------------------------------------------
+// xrpn_queue - decl.
+//
+// Fixed-capacity, lock-free single-producer/single-consumer ring;
+// events are dropped (and counted) on overflow.
+
+class xrpn_queue
+{
+public:
+
+	// Ring capacity (must be a power of two).
+	static const unsigned int Size = 1024;
+
+	xrpn_queue () : m_read(0), m_write(0), m_drops(0) {}
+
+	void clear()
+		{ m_read.storeRelease(m_write.loadAcquire()); }
+
 	bool push ( unsigned long time, int port,
 		unsigned char status, unsigned short param, unsigned short value )
 	{
-		qxgeditMidiRpn::Event event;
+		const unsigned int r = m_read.loadAcquire();
+		const unsigned int w = m_write.load();
+		if (w - r >= Size) {
+			m_drops.fetchAndAddRelaxed(1);
+			return false;
+		}
+
+		qxgeditMidiRpn::Event& event = m_events[w & (Size - 1)];
 
 		event.time   = time;
 		event.port   = port;
@@ -264,50 +309,47 @@ public:
 		event.param  = param;
 		event.value  = value;
 
-		return push(event);
+		m_write.storeRelease(w + 1);
+		return true;
 	}
 
 	bool push ( const qxgeditMidiRpn::Event& event )
 	{
-		if (count() >= m_mask)
-			resize(m_size + 4);
-		const unsigned int w = (m_write + 1) & m_mask;
-		if (w == m_read)
-			return false;
-		m_events[m_write] = event;
-		m_write = w;
-		return true;
+		return push(event.time, event.port,
+			event.status, event.param, event.value);
 	}
 
 	bool pop ( qxgeditMidiRpn::Event& event )
 	{
-		const unsigned int r = m_read;
-		if (r == m_write)
+		const unsigned int r = m_read.load();
+		if (r == (unsigned int) m_write.loadAcquire())
 			return false;
-		event = m_events[r]; 
-		m_read = (r + 1) & m_mask;
+		event = m_events[r & (Size - 1)];
+		m_read.storeRelease(r + 1);
 		return true;
 	}
 
 	bool is_pending () const
-		{ return (m_read != m_write); }
+		{ return (m_read.loadAcquire() != m_write.loadAcquire()); }
 
- 	unsigned int count() const
+	unsigned int count() const
 	{
-		if (m_write < m_read)
-			return (m_write + m_size - m_read) & m_mask;
-		else
-			return (m_write - m_read);
+		const unsigned int r = m_read.loadAcquire();
+		const unsigned int w = m_write.loadAcquire();
+		return w - r;
 	}
 
+	// Overflow statistics.
+	unsigned int drops() const
+		{ return m_drops.load(); }
+
 private:
 
-	unsigned int m_size;
-	unsigned int m_mask;
-	unsigned int m_read;
-	unsigned int m_write;
+	qxgeditMidiRpn::Event m_events[Size];
 
-	qxgeditMidiRpn::Event *m_events;
+	QAtomicInt m_read;
+	QAtomicInt m_write;
+	QAtomicInt m_drops;
 };
 
 
@@ -318,7 +360,7 @@ class qxgeditMidiRpn::Impl
 {
 public:
 
-	Impl() : m_count(0) {}
+	Impl() : m_count(0), m_window(0) { m_timer.start(); }
 
 	bool is_pending () const
 		{ return m_queue.is_pending(); }
@@ -326,19 +368,85 @@ public:
 	bool dequeue ( qxgeditMidiRpn::Event& event )
 		{ return m_queue.pop(event); }
 
+	unsigned int drop_count () const
+		{ return m_queue.drops(); }
+
 	void flush()
 	{
 		if (m_count > 0) {
-			xrpn_cache::Iterator iter = m_cache.begin();
-			const xrpn_cache::Iterator& iter_end = m_cache.end();
-			for ( ; iter != iter_end; ++iter)
-				enqueue(iter.value());
+			for (unsigned int i = 0; i < xrpn_cache::Size; ++i) {
+				if (m_cache.is_used(i))
+					enqueue(m_cache.at(i));
+			}
 			m_cache.clear();
 		//	m_count = 0;
 		}
 	}
 
+	void set_flush_window ( unsigned int window )
+		{ m_window = window; }
+	unsigned int flush_window () const
+		{ return m_window; }
+
+	int flush_timeout () const
+	{
+		if (m_window == 0 || m_cache.is_empty())
+			return -1;
+
+		const qint64 now = m_timer.elapsed();
+		qint64 timeout = -1;
+
+		for (unsigned int i = 0; i < xrpn_cache::Size; ++i) {
+			if (!m_cache.is_used(i))
+				continue;
+			const xrpn_item& item = m_cache.at(i);
+			if (!item.is_status() || !item.is_value_any())
+				continue;
+			qint64 t = item.stamp() + m_window - now;
+			if (t < 0)
+				t = 0;
+			if (timeout < 0 || t < timeout)
+				timeout = t;
+		}
+
+		return int(timeout);
+	}
+
+	void flush_expired ()
+	{
+		if (m_window == 0 || m_cache.is_empty())
+			return;
+
+		const qint64 now = m_timer.elapsed();
+
+		for (unsigned int i = 0; i < xrpn_cache::Size; ++i) {
+			if (!m_cache.is_used(i))
+				continue;
+			xrpn_item& item = m_cache.at(i);
+			if (!item.is_status() || !item.is_value_any())
+				continue;
+			if (now - item.stamp() >= qint64(m_window))
+				enqueue(item);
+		}
+	}
+
 	bool process ( const qxgeditMidiRpn::Event& event )
+	{
+		if (!process_event(event))
+			return false;
+
+		// Stamp the (last) received part, for flush deadlines...
+		if (m_window > 0) {
+			get_item(event.port, (event.status & 0x0f))
+				.set_stamp(m_timer.elapsed());
+		}
+
+		return true;
+	}
+
+protected:
+
+	bool process_event ( const qxgeditMidiRpn::Event& event )
 	{
 		const unsigned short channel = (event.status & 0x0f);
 
@@ -537,10 +645,8 @@ public:
 		return false;
 	}
 
-protected:
-
 	xrpn_item& get_item ( int port, unsigned short channel )
-		{ return m_cache[(port << 4) | channel]; }
+		{ return m_cache.item(port, channel); }
 
 	void enqueue ( xrpn_item& item )
 	{
@@ -577,6 +683,15 @@ protected:
 			item.clear_value();
 			item.set_time(0);
 		//	--m_count;
+		}
+		else
+		if (item.is_param_msb() && item.is_param_lsb()
+			&& item.is_value_msb() && !item.is_value_lsb()) {
+			// Data Entry MSB only (7bit value)...
+			m_queue.push(time, port, item.status(), item.param(), item.value_msb());
+			item.clear_value();
+			item.set_time(0);
+		//	--m_count;
 		} else {
 			const unsigned char status = qxgeditMidiRpn::CC | item.channel();
 			if (item.type() == qxgeditMidiRpn::RPN) {
@@ -607,6 +722,9 @@ private:
 
 	xrpn_cache m_cache;
 	xrpn_queue m_queue;
+
+	unsigned int  m_window;
+	QElapsedTimer m_timer;
 };
 
 
@@ -650,4 +768,75 @@ void qxgeditMidiRpn::flush (void)
 }
 
 
+unsigned int qxgeditMidiRpn::dropCount (void) const
+{
+	return m_pImpl->drop_count();
+}
+
+
+void qxgeditMidiRpn::setFlushWindow ( unsigned int iFlushWindow )
+{
+	m_pImpl->set_flush_window(iFlushWindow);
+}
+
+
+unsigned int qxgeditMidiRpn::flushWindow (void) const
+{
+	return m_pImpl->flush_window();
+}
+
+
+int qxgeditMidiRpn::flushTimeout (void) const
+{
+	return m_pImpl->flush_timeout();
+}
+
+
+void qxgeditMidiRpn::flushExpired (void)
+{
+	m_pImpl->flush_expired();
+}
+
+
+//---------------------------------------------------------------------
+// qxgeditMidiNrpnEncoder - impl.
+//
+
+qxgeditMidiNrpnEncoder::qxgeditMidiNrpnEncoder (void)
+{
+	reset();
+}
+
+
+void qxgeditMidiNrpnEncoder::reset (void)
+{
+	for (unsigned short i = 0; i < 16; ++i)
+		m_nrpn[i] = 0xffff;
+}
+
+
+unsigned short qxgeditMidiNrpnEncoder::encode ( unsigned char channel,
+	unsigned short nrpn, unsigned char value, Controller *ctls )
+{
+	unsigned short n = 0;
+
+	nrpn &= 0x3fff;
+	if (m_nrpn[channel & 0x0f] != nrpn) {
+		ctls[n].param = NRPN_MSB;
+		ctls[n].value = (nrpn >> 7);
+		++n;
+		ctls[n].param = NRPN_LSB;
+		ctls[n].value = (nrpn & 0x7f);
+		++n;
+		m_nrpn[channel & 0x0f] = nrpn;
+	}
+
+	ctls[n].param = DATA_MSB;
+	ctls[n].value = (value & 0x7f);
+	++n;
+
+	return n;
+}
+
+
 // end of qxgeditMidiRpn.cpp
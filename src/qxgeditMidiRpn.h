@@ -52,6 +52,21 @@ public:
 
 	void flush();
 
+	// Output queue overflow statistics.
+	unsigned int dropCount() const;
+
+	// Deadline-driven flush of half-received items
+	// (window in msecs since last received part; 0=off).
+	void setFlushWindow(unsigned int iFlushWindow);
+	unsigned int flushWindow() const;
+
+	// Time to next flush deadline (msecs; -1=none, as
+	// when no flush window is set or no value is pending).
+	int flushTimeout() const;
+
+	// Flush half-received items past their deadline.
+	void flushExpired();
+
 private:
 
 	class Impl;
@@ -60,6 +75,42 @@ private:
 };
 
 
+//---------------------------------------------------------------------
+// qxgeditMidiNrpnEncoder - decl.
+//
+// NRPN controller event encoder, keeping track of the wire state:
+// the NRPN select (CC#99/98) is skipped when the target parameter
+// is unchanged on the channel, leaving the Data Entry (CC#6) only.
+
+class qxgeditMidiNrpnEncoder
+{
+public:
+
+	qxgeditMidiNrpnEncoder();
+
+	// Controller event (CC number and 7bit value).
+	struct Controller
+	{
+		unsigned char param;
+		unsigned char value;
+	};
+
+	// Maximum encoded message size (controller events).
+	static const unsigned short MaxCount = 3;
+
+	// Forget all wire state (eg. on connection changes).
+	void reset();
+
+	// Encode a NRPN 7bit value (returns number of controller events).
+	unsigned short encode(unsigned char channel,
+		unsigned short nrpn, unsigned char value, Controller *ctls);
+
+private:
+
+	unsigned short m_nrpn[16];
+};
+
+
 #endif	//  __qxgeditMidiRpn_h
 
 // end of qxgeditMidiRpn.h
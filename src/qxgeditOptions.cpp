@@ -48,7 +48,7 @@ qxgeditOptions *qxgeditOptions::getInstance (void)
 
 // Constructor.
 qxgeditOptions::qxgeditOptions (void)
-	: m_settings(QXGEDIT_DOMAIN, QXGEDIT_TITLE)
+	: bProfileStartup(false), m_settings(QXGEDIT_DOMAIN, QXGEDIT_TITLE)
 {
 	// Pseudo-singleton reference setup.
 	g_pOptions = this;
@@ -77,6 +77,11 @@ void qxgeditOptions::loadOptions (void)
 	m_settings.beginGroup("/Midi");
 	midiInputs  = m_settings.value("/Inputs").toStringList();
 	midiOutputs = m_settings.value("/Outputs").toStringList();
+	iMidiOutputRate = m_settings.value("/OutputRate", 3125).toInt();
+	iMidiRpnFlushWindow = m_settings.value("/RpnFlushWindow", 10).toInt();
+	bMidiNrpnOutput = m_settings.value("/NrpnOutput", false).toBool();
+	iMidiDumpRequestWindow = m_settings.value("/DumpRequestWindow", 4).toInt();
+	iMidiDumpRequestTimeout = m_settings.value("/DumpRequestTimeout", 500).toInt();
 	m_settings.endGroup();
 
 	// Load display options...
@@ -129,6 +134,11 @@ void qxgeditOptions::saveOptions (void)
 	m_settings.beginGroup("/Midi");
 	m_settings.setValue("/Inputs", midiInputs);
 	m_settings.setValue("/Outputs", midiOutputs);
+	m_settings.setValue("/OutputRate", iMidiOutputRate);
+	m_settings.setValue("/RpnFlushWindow", iMidiRpnFlushWindow);
+	m_settings.setValue("/NrpnOutput", bMidiNrpnOutput);
+	m_settings.setValue("/DumpRequestWindow", iMidiDumpRequestWindow);
+	m_settings.setValue("/DumpRequestTimeout", iMidiDumpRequestTimeout);
 	m_settings.endGroup();
 
 	// Save display options.
@@ -192,7 +202,9 @@ void qxgeditOptions::print_usage ( const QString& arg0 )
 		QXGEDIT_TITLE " - " QXGEDIT_SUBTITLE "\n\n"
 		"Options:\n\n"
 		"  -h, --help\n\tShow help about command line options\n\n"
-		"  -v, --version\n\tShow version information\n\n")
+		"  -v, --version\n\tShow version information\n\n"
+		"  --profile-startup\n\tPrint a startup phase timing breakdown and exit\n\n"
+		"  --benchmark\n\tRun the micro-benchmarks (headless) and exit\n\n")
 		.arg(arg0);
 }
 
@@ -231,6 +243,9 @@ bool qxgeditOptions::parse_args ( const QStringList& args )
 				.arg(CONFIG_BUILD_VERSION);
 			return false;
 		}
+		else if (sArg == "--profile-startup") {
+			bProfileStartup = true;
+		}
 		else {
 			// If we don't have one by now,
 			// this will be the startup session file...
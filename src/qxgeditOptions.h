@@ -56,6 +56,9 @@ public:
 	// Startup supplied session file.
 	QString sSessionFile;
 
+	// Startup profiling mode (command line only).
+	bool bProfileStartup;
+
 	// Display options...
 	bool    bConfirmReset;
 	bool    bConfirmRemove;
@@ -81,6 +84,11 @@ public:
 	// MIDI specific options.
 	QStringList midiInputs;
 	QStringList midiOutputs;
+	int         iMidiOutputRate;
+	int         iMidiRpnFlushWindow;
+	bool        bMidiNrpnOutput;
+	int         iMidiDumpRequestWindow;
+	int         iMidiDumpRequestTimeout;
 
 	// (QS300) USER VOICE Specific options.
 	bool bUservoiceAutoSend;
@@ -72,6 +72,21 @@ qxgeditOptionsForm::qxgeditOptionsForm ( QWidget *pParent )
 	QObject::connect(m_ui.MidiOutputListView,
 		SIGNAL(itemSelectionChanged()),
 		SLOT(midiOutputsChanged()));
+	QObject::connect(m_ui.MidiNrpnOutputCheckBox,
+		SIGNAL(stateChanged(int)),
+		SLOT(changed()));
+	QObject::connect(m_ui.MidiOutputRateSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(changed()));
+	QObject::connect(m_ui.MidiRpnFlushWindowSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(changed()));
+	QObject::connect(m_ui.MidiDumpRequestWindowSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(changed()));
+	QObject::connect(m_ui.MidiDumpRequestTimeoutSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(changed()));
 	QObject::connect(m_ui.ConfirmResetCheckBox,
 		SIGNAL(stateChanged(int)),
 		SLOT(changed()));
@@ -148,6 +163,13 @@ void qxgeditOptionsForm::setOptions ( qxgeditOptions *pOptions )
 	m_iMidiInputsChanged  = 0;
 	m_iMidiOutputsChanged = 0;
 
+	// MIDI options.
+	m_ui.MidiNrpnOutputCheckBox->setChecked(m_pOptions->bMidiNrpnOutput);
+	m_ui.MidiOutputRateSpinBox->setValue(m_pOptions->iMidiOutputRate);
+	m_ui.MidiRpnFlushWindowSpinBox->setValue(m_pOptions->iMidiRpnFlushWindow);
+	m_ui.MidiDumpRequestWindowSpinBox->setValue(m_pOptions->iMidiDumpRequestWindow);
+	m_ui.MidiDumpRequestTimeoutSpinBox->setValue(m_pOptions->iMidiDumpRequestTimeout);
+
 	// Other options finally.
 	m_ui.ConfirmResetCheckBox->setChecked(m_pOptions->bConfirmReset);
 	m_ui.ConfirmRemoveCheckBox->setChecked(m_pOptions->bConfirmRemove);
@@ -206,6 +228,12 @@ void qxgeditOptionsForm::accept (void)
 
 	// Save options...
 	if (m_iDirtyCount > 0) {
+		// MIDI options...
+		m_pOptions->bMidiNrpnOutput = m_ui.MidiNrpnOutputCheckBox->isChecked();
+		m_pOptions->iMidiOutputRate = m_ui.MidiOutputRateSpinBox->value();
+		m_pOptions->iMidiRpnFlushWindow = m_ui.MidiRpnFlushWindowSpinBox->value();
+		m_pOptions->iMidiDumpRequestWindow = m_ui.MidiDumpRequestWindowSpinBox->value();
+		m_pOptions->iMidiDumpRequestTimeout = m_ui.MidiDumpRequestTimeoutSpinBox->value();
 		// Display options...
 		m_pOptions->bConfirmReset   = m_ui.ConfirmResetCheckBox->isChecked();
 		m_pOptions->bConfirmRemove  = m_ui.ConfirmRemoveCheckBox->isChecked();
@@ -0,0 +1,113 @@
+// qxgeditProfile.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qxgeditProfile.h"
+
+#include <cstdio>
+
+
+//-------------------------------------------------------------------------
+// qxgeditProfile - Startup phase profiler (pseudo-singleton).
+//
+
+// Pseudo-singleton reference.
+qxgeditProfile *qxgeditProfile::g_pProfile = nullptr;
+
+
+// Constructor.
+qxgeditProfile::qxgeditProfile (void)
+{
+	m_timer.start();
+
+	g_pProfile = this;
+}
+
+
+// Destructor.
+qxgeditProfile::~qxgeditProfile (void)
+{
+	g_pProfile = nullptr;
+}
+
+
+// Pseudo-singleton accessor.
+qxgeditProfile *qxgeditProfile::getInstance (void)
+{
+	return g_pProfile;
+}
+
+
+// Phase end timestamp marker (no-op when not profiling).
+void qxgeditProfile::mark ( const char *pszPhase )
+{
+	if (g_pProfile == nullptr)
+		return;
+
+	Mark mark;
+	mark.phase = pszPhase;
+	mark.nsecs = g_pProfile->m_timer.nsecsElapsed();
+	g_pProfile->m_marks.append(mark);
+}
+
+
+// Named counter sample (no-op when not profiling).
+void qxgeditProfile::count ( const char *pszName, qint64 iValue )
+{
+	if (g_pProfile == nullptr)
+		return;
+
+	Count count;
+	count.name  = pszName;
+	count.value = iValue;
+	g_pProfile->m_counts.append(count);
+}
+
+
+// Per-phase breakdown report (to stderr).
+void qxgeditProfile::report (void) const
+{
+	fprintf(stderr, "\n%-40s %12s %12s\n", "Startup phase", "Phase ms", "Total ms");
+
+	qint64 nsecs0 = 0;
+	QListIterator<Mark> iter(m_marks);
+	while (iter.hasNext()) {
+		const Mark& mark = iter.next();
+		fprintf(stderr, "%-40s %12.3f %12.3f\n", mark.phase,
+			double(mark.nsecs - nsecs0) / 1000000.0,
+			double(mark.nsecs) / 1000000.0);
+		nsecs0 = mark.nsecs;
+	}
+
+	if (!m_counts.isEmpty()) {
+		fprintf(stderr, "\n%-40s %12s\n", "Counter", "Value");
+		QListIterator<Count> iter2(m_counts);
+		while (iter2.hasNext()) {
+			const Count& count = iter2.next();
+			fprintf(stderr, "%-40s %12lld\n", count.name,
+				(long long) count.value);
+		}
+	}
+
+	fprintf(stderr, "\n");
+}
+
+
+// end of qxgeditProfile.cpp
@@ -0,0 +1,83 @@
+// qxgeditProfile.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qxgeditProfile_h
+#define __qxgeditProfile_h
+
+#include <QElapsedTimer>
+#include <QList>
+
+
+//-------------------------------------------------------------------------
+// qxgeditProfile - Startup phase profiler (pseudo-singleton).
+//
+
+class qxgeditProfile
+{
+public:
+
+	// Constructor.
+	qxgeditProfile();
+
+	// Destructor.
+	~qxgeditProfile();
+
+	// Pseudo-singleton accessor.
+	static qxgeditProfile *getInstance();
+
+	// Phase end timestamp marker (no-op when not profiling).
+	static void mark(const char *pszPhase);
+
+	// Named counter sample (no-op when not profiling).
+	static void count(const char *pszName, qint64 iValue);
+
+	// Per-phase breakdown report (to stderr).
+	void report() const;
+
+private:
+
+	// Phase timestamp record.
+	struct Mark
+	{
+		const char *phase;
+		qint64      nsecs;
+	};
+
+	// Named counter record.
+	struct Count
+	{
+		const char *name;
+		qint64      value;
+	};
+
+	// Instance variables.
+	QElapsedTimer m_timer;
+	QList<Mark>   m_marks;
+	QList<Count>  m_counts;
+
+	// Pseudo-singleton reference.
+	static qxgeditProfile *g_pProfile;
+};
+
+
+#endif	// __qxgeditProfile_h
+
+// end of qxgeditProfile.h
@@ -0,0 +1,369 @@
+// qxgeditXGDumpRequest.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2021, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qxgeditAbout.h"
+#include "qxgeditXGDumpRequest.h"
+
+#include "qxgeditMidiDevice.h"
+
+
+// Timeout and retry check period (msecs).
+#define XGDUMP_TIMER_PERIOD  20
+
+
+//----------------------------------------------------------------------------
+// qxgeditXGDumpRequest -- XG Dump Request readback engine.
+
+// Constructor.
+qxgeditXGDumpRequest::qxgeditXGDumpRequest ( QObject *pParent )
+	: QObject(pParent), m_iWindow(4), m_iTimeout(500), m_iRetries(3),
+		m_iTotalCount(0), m_iReplyCount(0), m_iRetryCount(0), m_iFailCount(0)
+{
+	m_timer.setInterval(XGDUMP_TIMER_PERIOD);
+
+	QObject::connect(&m_timer,
+		SIGNAL(timeout()),
+		SLOT(timerSlot()));
+}
+
+
+// Destructor.
+qxgeditXGDumpRequest::~qxgeditXGDumpRequest (void)
+{
+	stop();
+}
+
+
+// Maximum number of outstanding requests.
+void qxgeditXGDumpRequest::setWindow ( int iWindow )
+{
+	m_iWindow = (iWindow > 0 ? iWindow : 1);
+}
+
+int qxgeditXGDumpRequest::window (void) const
+{
+	return m_iWindow;
+}
+
+
+// Reply timeout (msecs).
+void qxgeditXGDumpRequest::setTimeout ( int iTimeout )
+{
+	m_iTimeout = (iTimeout > XGDUMP_TIMER_PERIOD ? iTimeout : XGDUMP_TIMER_PERIOD);
+}
+
+int qxgeditXGDumpRequest::timeout (void) const
+{
+	return m_iTimeout;
+}
+
+
+// Maximum number of retries per request.
+void qxgeditXGDumpRequest::setRetries ( int iRetries )
+{
+	m_iRetries = (iRetries > 0 ? iRetries : 0);
+}
+
+int qxgeditXGDumpRequest::retries (void) const
+{
+	return m_iRetries;
+}
+
+
+// Full-state readback start.
+void qxgeditXGDumpRequest::start (void)
+{
+	stop();
+
+	m_iTotalCount = 0;
+	m_iReplyCount = 0;
+	m_iRetryCount = 0;
+	m_iFailCount  = 0;
+
+	unsigned short i, j;
+
+	// SYSTEM...
+	addRequest(0x4c, 0x00, 0x00, 0x00);
+
+	// EFFECT (REVERB, CHORUS, VARIATION)...
+	addRequest(0x4c, 0x02, 0x01, 0x00);
+	addRequest(0x4c, 0x02, 0x01, 0x20);
+	addRequest(0x4c, 0x02, 0x01, 0x40);
+
+	// MULTIPART (all 16 parts)...
+	for (i = 0; i < 16; ++i)
+		addRequest(0x4c, 0x08, i, 0x00);
+
+	// DRUMSETUP (both drumsets, all notes)...
+	for (j = 0; j < 2; ++j) {
+		for (i = 13; i < 85; ++i)
+			addRequest(0x4c, 0x30 + j, i, 0x00);
+	}
+
+	// (QS300) USERVOICE (first user voice only, as a probe:
+	// the remaining ones are only requested if this one is
+	// replied; a plain XG module won't ever answer it)...
+	addRequest(0x4b, 0x11, 0x00, 0x00);
+
+	m_iTotalCount = m_pending.count();
+
+	m_elapsed.start();
+	m_timer.start();
+
+	pump();
+}
+
+
+// Full-state readback stop.
+void qxgeditXGDumpRequest::stop (void)
+{
+	m_timer.stop();
+
+	m_pending.clear();
+	m_outstanding.clear();
+}
+
+
+bool qxgeditXGDumpRequest::isActive (void) const
+{
+	return m_timer.isActive();
+}
+
+
+// Reply matcher (returns the number of matched requests).
+int qxgeditXGDumpRequest::received ( const unsigned char *data, unsigned short len )
+{
+	if (m_outstanding.isEmpty())
+		return 0;
+
+	// Native Bulk Dump replies only (Parameter Change echoes don't count)...
+	if (len < 11 || data[0] != 0xf0 || data[1] != 0x43
+		|| (data[2] & 0x70) != 0x00)
+		return 0;
+
+	// Byte count must fit in the message...
+	const unsigned short size = (data[4] << 7) + data[5];
+	if (size + 11 > len)
+		return 0;
+
+	// Same model and block start address...
+	const unsigned char  model = data[3];
+	const unsigned short high  = data[6];
+	const unsigned short mid   = data[7];
+	const unsigned short low   = data[8];
+
+	int nmatch = 0;
+
+	QList<Request>::Iterator req = m_outstanding.begin();
+	const QList<Request>::Iterator& req_end = m_outstanding.end();
+	for ( ; req != req_end; ++req) {
+		if (req->model == model
+			&& req->high == high
+			&& req->mid  == mid
+			&& req->low  == low) {
+			m_outstanding.erase(req);
+			++m_iReplyCount;
+			++nmatch;
+			break;
+		}
+	}
+
+	// (QS300) USERVOICE probe replied: request all the others...
+	if (nmatch > 0 && model == 0x4b && high == 0x11 && mid == 0x00) {
+		for (unsigned short i = 1; i < 32; ++i)
+			addRequest(0x4b, 0x11, i, 0x00);
+		m_iTotalCount += 31;
+	}
+
+	if (nmatch > 0) {
+		pump();
+		emit progress(m_iReplyCount + m_iFailCount, m_iTotalCount);
+		check();
+	}
+
+	return nmatch;
+}
+
+
+// Readback statistics.
+int qxgeditXGDumpRequest::totalCount (void) const
+{
+	return m_iTotalCount;
+}
+
+int qxgeditXGDumpRequest::replyCount (void) const
+{
+	return m_iReplyCount;
+}
+
+int qxgeditXGDumpRequest::retryCount (void) const
+{
+	return m_iRetryCount;
+}
+
+int qxgeditXGDumpRequest::failCount (void) const
+{
+	return m_iFailCount;
+}
+
+
+// Elapsed time since start (msecs).
+qint64 qxgeditXGDumpRequest::elapsed (void) const
+{
+	return (m_elapsed.isValid() ? m_elapsed.elapsed() : 0);
+}
+
+
+// Timeout and retry check.
+void qxgeditXGDumpRequest::timerSlot (void)
+{
+	const qint64 now = m_elapsed.elapsed();
+
+	int nfail = 0;
+
+	QList<Request>::Iterator req = m_outstanding.begin();
+	while (req != m_outstanding.end()) {
+		if (req->deadline > now) {
+			++req;
+			continue;
+		}
+		if (req->retries < m_iRetries) {
+			++(req->retries);
+			++m_iRetryCount;
+			sendRequest(*req);
+			++req;
+		} else {
+		#ifdef CONFIG_DEBUG
+			qDebug("qxgeditXGDumpRequest: no reply for %02x %02x %02x %02x.",
+				req->model, req->high, req->mid, req->low);
+		#endif
+			// (QS300) USERVOICE unanswered: don't bother with the rest...
+			if (req->model == 0x4b)
+				m_iTotalCount -= removeRequests(req->model);
+			req = m_outstanding.erase(req);
+			++m_iFailCount;
+			++nfail;
+		}
+	}
+
+	if (nfail > 0) {
+		pump();
+		emit progress(m_iReplyCount + m_iFailCount, m_iTotalCount);
+	}
+
+	check();
+}
+
+
+// Request list builder.
+void qxgeditXGDumpRequest::addRequest ( unsigned char model,
+	unsigned short high, unsigned short mid, unsigned short low )
+{
+	Request request;
+
+	request.model    = model;
+	request.high     = high;
+	request.mid      = mid;
+	request.low      = low;
+	request.retries  = 0;
+	request.deadline = 0;
+
+	m_pending.append(request);
+}
+
+
+// Remove all pending requests of a model (returns how many).
+int qxgeditXGDumpRequest::removeRequests ( unsigned char model )
+{
+	int nremove = 0;
+
+	QList<Request>::Iterator req = m_pending.begin();
+	while (req != m_pending.end()) {
+		if (req->model == model) {
+			req = m_pending.erase(req);
+			++nremove;
+		} else {
+			++req;
+		}
+	}
+
+	return nremove;
+}
+
+
+// Send out a dump request message.
+void qxgeditXGDumpRequest::sendRequest ( Request& request )
+{
+	request.deadline = m_elapsed.elapsed() + m_iTimeout;
+
+	qxgeditMidiDevice *pMidiDevice = qxgeditMidiDevice::getInstance();
+	if (pMidiDevice == nullptr)
+		return;
+
+	unsigned char data[8];
+
+	data[0] = 0xf0;	// SOX
+	data[1] = 0x43;	// Yamaha ID
+	data[2] = 0x20;	// Dump Request, device no. 0
+	data[3] = request.model;
+	data[4] = request.high;
+	data[5] = request.mid;
+	data[6] = request.low;
+	data[7] = 0xf7;	// EOX
+
+	pMidiDevice->sendSysex(data, sizeof(data));
+
+	// Reply timeout starts when the request is actually on the wire,
+	// ie. after whatever is still pending on the paced output queue...
+	request.deadline += pMidiDevice->outputDrainTime();
+}
+
+
+// Fill the outstanding request window.
+void qxgeditXGDumpRequest::pump (void)
+{
+	while (m_outstanding.count() < m_iWindow && !m_pending.isEmpty()) {
+		Request request = m_pending.takeFirst();
+		sendRequest(request);
+		m_outstanding.append(request);
+	}
+}
+
+
+// Check for completion.
+void qxgeditXGDumpRequest::check (void)
+{
+	if (!m_timer.isActive())
+		return;
+
+	if (m_pending.isEmpty() && m_outstanding.isEmpty()) {
+		m_timer.stop();
+	#ifdef CONFIG_DEBUG
+		qDebug("qxgeditXGDumpRequest: %d/%d replied, %d retries, %d failed (%lld msecs).",
+			m_iReplyCount, m_iTotalCount, m_iRetryCount, m_iFailCount,
+			m_elapsed.elapsed());
+	#endif
+		emit finished();
+	}
+}
+
+
+// end of qxgeditXGDumpRequest.cpp
@@ -0,0 +1,149 @@
+// qxgeditXGDumpRequest.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2021, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qxgeditXGDumpRequest_h
+#define __qxgeditXGDumpRequest_h
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+
+
+//----------------------------------------------------------------------------
+// qxgeditXGDumpRequest -- XG Dump Request readback engine.
+//
+// Issues XG Dump Requests for the whole module state (SYSTEM, EFFECT,
+// all MULTIPART parts, both DRUMSETUP banks and QS300 USERVOICE),
+// keeping a window of outstanding requests; replies are matched by
+// model and block start address (Native Bulk Dump messages only) and
+// timed out requests are retried a few times, before being given up.
+// QS300 USERVOICE is probed with the first user voice only; the other
+// ones are requested once that is replied, and given up altogether on
+// the first one left unanswered.
+
+class qxgeditXGDumpRequest : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qxgeditXGDumpRequest(QObject *pParent = nullptr);
+
+	// Destructor.
+	~qxgeditXGDumpRequest();
+
+	// Maximum number of outstanding requests.
+	void setWindow(int iWindow);
+	int window() const;
+
+	// Reply timeout (msecs).
+	void setTimeout(int iTimeout);
+	int timeout() const;
+
+	// Maximum number of retries per request.
+	void setRetries(int iRetries);
+	int retries() const;
+
+	// Full-state readback start/stop.
+	void start();
+	void stop();
+
+	bool isActive() const;
+
+	// Reply matcher (returns the number of matched requests).
+	int received(const unsigned char *data, unsigned short len);
+
+	// Readback statistics.
+	int totalCount() const;
+	int replyCount() const;
+	int retryCount() const;
+	int failCount() const;
+
+	// Elapsed time since start (msecs).
+	qint64 elapsed() const;
+
+signals:
+
+	// Progress notification (replied or given up requests).
+	void progress(int iDone, int iTotal);
+
+	// Readback complete notification.
+	void finished();
+
+protected slots:
+
+	// Timeout and retry check.
+	void timerSlot();
+
+protected:
+
+	// Dump request item.
+	struct Request
+	{
+		unsigned char  model;
+		unsigned short high;
+		unsigned short mid;
+		unsigned short low;
+		int            retries;
+		qint64         deadline;
+	};
+
+	// Request list builder.
+	void addRequest(unsigned char model,
+		unsigned short high, unsigned short mid, unsigned short low);
+
+	// Remove all pending requests of a model.
+	int removeRequests(unsigned char model);
+
+	// Send out a dump request message.
+	void sendRequest(Request& request);
+
+	// Fill the outstanding request window.
+	void pump();
+
+	// Check for completion.
+	void check();
+
+private:
+
+	// Instance variables.
+	int m_iWindow;
+	int m_iTimeout;
+	int m_iRetries;
+
+	QList<Request> m_pending;
+	QList<Request> m_outstanding;
+
+	int m_iTotalCount;
+	int m_iReplyCount;
+	int m_iRetryCount;
+	int m_iFailCount;
+
+	QTimer        m_timer;
+	QElapsedTimer m_elapsed;
+};
+
+
+#endif	// __qxgeditXGDumpRequest_h
+
+// end of qxgeditXGDumpRequest.h
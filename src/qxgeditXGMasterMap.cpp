@@ -22,6 +22,8 @@
 #include "qxgeditAbout.h"
 #include "qxgeditXGMasterMap.h"
 
+#include "qxgeditProfile.h"
+
 #include "qxgeditMidiDevice.h"
 
 #include "qxgeditMainForm.h"
@@ -29,6 +31,10 @@
 #include "XGParamSysex.h"
 
 #include <cstdio>
+#include <cstring>
+#include <new>
+
+#include <algorithm>
 
 
 //----------------------------------------------------------------------------
@@ -53,6 +59,9 @@ void qxgeditXGMasterMap::Observer::update (void)
 
 	XGParam *pParam = param();
 
+	// Undo/redo journal choke point...
+	pMasterMap->journal_add(pParam);
+
 #ifdef CONFIG_DEBUG_0
 	qDebug("qxgeditXGMasterMap::Observer[%p]::update() [%02x %02x %02x %s %u]",
 		this, pParam->high(), pParam->mid(), pParam->low(),
@@ -72,7 +81,12 @@ void qxgeditXGMasterMap::Observer::update (void)
 		pMasterMap->send_param(pParam);
 	}
 
-	// HACK: Flag dirty the main form...
+	// HACK: Flag dirty the main form (once per bulk-send batch)...
+	if (pMasterMap->m_bulk > 0) {
+		pMasterMap->m_bulk_dirty = true;
+		return;
+	}
+
 	qxgeditMainForm *pMainForm = qxgeditMainForm::getInstance();
 	if (pMainForm)
 		pMainForm->contentsChanged();
@@ -85,30 +99,67 @@ void qxgeditXGMasterMap::Observer::update (void)
 
 // Constructor.
 qxgeditXGMasterMap::qxgeditXGMasterMap (void)
-	: XGParamMasterMap(), m_auto_send(false)
+	: XGParamMasterMap(), m_auto_send(false), m_nrpn_output(false),
+		m_bulk(0), m_bulk_dirty(false),
+		m_journal_begin(0), m_journal_count(0), m_journal_pos(0),
+		m_journal_step(0), m_journal_batch(false), m_journal_replay(false)
 {
-	// Setup local observers...
-	XGParamMasterMap::const_iterator iter
-		= XGParamMasterMap::constBegin();
-	for (; iter != XGParamMasterMap::constEnd(); ++iter) {
-		XGParam *pParam = iter.value();
-		m_observers.insert(pParam, new Observer(pParam));
+	// Setup local observers (arena backed)...
+	XGParamArena& arena = XGParamMasterMap::arena();
+	m_observers.reserve(XGParamMasterMap::params().count());
+	QListIterator<XGParam *> iter(XGParamMasterMap::params());
+	while (iter.hasNext()) {
+		XGParam *pParam = iter.next();
+		m_observers.insert(pParam,
+			new (arena.alloc(sizeof(Observer))) Observer(pParam));
+	}
+
+	qxgeditProfile::mark("qxgeditXGMasterMap: observers");
+
+#ifdef CONFIG_DEBUG
+	unsigned long iParamBytes = 0;
+	QListIterator<XGParam *> iter2(XGParamMasterMap::params());
+	while (iter2.hasNext()) {
+		XGParam *pParam = iter2.next();
+		switch (pParam->kind()) {
+		case XGParam::Effect:
+			iParamBytes += sizeof(XGEffectParam);
+			break;
+		case XGParam::Data:
+			iParamBytes += sizeof(XGDataParam) + pParam->size();
+			break;
+		default:
+			iParamBytes += sizeof(XGParam);
+			break;
+		}
 	}
+	qDebug("qxgeditXGMasterMap::qxgeditXGMasterMap() %d params materialized"
+		" (%u bytes/param, %lu bytes total).", m_observers.count(),
+		(unsigned int) sizeof(XGParam), iParamBytes);
+#endif
 
 	reset_part_dirty();
 	reset_user_dirty();
+
+	// Undo/redo journal ring and last known values...
+	m_journal = new JournalItem [JournalSize];
+	m_journal_values = new unsigned short [plane_size()];
+	::memcpy(m_journal_values, values(), plane_size() * sizeof(unsigned short));
+	m_journal_timer.start();
 }
 
 
 // Destructor.
 qxgeditXGMasterMap::~qxgeditXGMasterMap (void)
 {
-	// Cleanup local observers...
-	// qDeleteAll(m_observers);
+	// Cleanup local observers (storage is bulk released by the arena)...
 	ObserverMap::const_iterator iter = m_observers.constBegin();
 	for (; iter != m_observers.constEnd(); ++iter)
-		delete iter.value();
+		iter.value()->~Observer();
 	m_observers.clear();
+
+	delete [] m_journal_values;
+	delete [] m_journal;
 }
 
 
@@ -164,7 +215,7 @@ bool qxgeditXGMasterMap::add_sysex_data (
 	SysexData& sysex_data, unsigned char *data, unsigned short len )
 {
 	 // SysEx (actually)...
-	if (data[0] != 0xf0 || data[len - 1] != 0xf7)
+	if (len < 4 || data[0] != 0xf0 || data[len - 1] != 0xf7)
 		return false;
 
 	// Yamaha ID...
@@ -179,13 +230,18 @@ bool qxgeditXGMasterMap::add_sysex_data (
 		// XG/QS300 Model ID...
 		if (mode == 0x00) {
 			// Native Bulk Dump...
+			if (len < 11)
+				return false;
 			const unsigned short size = (data[4] << 7) + data[5];
+			// Byte count must fit in the message (header+checksum+EOX)...
+			if (size + 11 > len)
+				return false;
 			unsigned char cksum = 0;
 			for (unsigned short i = 0; i < size + 5; ++i) {
 				cksum += data[4 + i];
 				cksum &= 0x7f;
 			}
-			if (data[9 + size] == 0x80 - cksum) {
+			if ((data[9 + size] & 0x7f) == ((0x80 - cksum) & 0x7f)) {
 				// Parameter Change...
 				const unsigned short high = data[6];
 				const unsigned short mid  = data[7];
@@ -197,7 +253,9 @@ bool qxgeditXGMasterMap::add_sysex_data (
 		}
 		else
 		if (mode == 0x10) {
-			// Parameter Change...
+			// Parameter Change (address+data+EOX)...
+			if (len < 8)
+				return false;
 			const unsigned short high = data[4];
 			const unsigned short mid  = data[5];
 			const unsigned short low  = data[6];
@@ -216,11 +274,34 @@ bool qxgeditXGMasterMap::set_sysex_data (
 {
 	int nparam = 0;
 
+	// Apply all in one batch (deferred notifications)...
+	begin_transaction();
+
 	SysexData::const_iterator iter = sysex_data.constBegin();
 	for (; iter != sysex_data.constEnd(); ++iter) {
 		const XGParamKey& key = iter.key();
 		const QByteArray& val = iter.value();
 		unsigned char *data = (unsigned char *) val.data();
+		// Known block type: single walk over its field layout...
+		const XGParamLayout *pLayout
+			= XGParamMasterMap::layout(key.high(), key.mid());
+		if (pLayout) {
+			const unsigned short low0 = key.low();
+			const unsigned short low1 = low0 + val.size();
+			for (unsigned short j = 0; j < pLayout->count; ++j) {
+				const XGParamField& field = pLayout->fields[j];
+				if (field.low < low0)
+					continue;
+				if (field.low + field.size > low1)
+					break;
+				XGParam *pParam = find_param(key.high(), key.mid(), field.low);
+				if (pParam && set_param_data(pParam, data + (field.low - low0), bNotify)
+					&& field.size > 1)
+					++nparam;
+			}
+			continue;
+		}
+		// Otherwise, byte by byte...
 		for (unsigned short i = 0; i < val.size(); ++i) {
 			// Parameter Change...
 			XGParam *pParam = find_param(key.high(), key.mid(), key.low() + i);
@@ -234,10 +315,32 @@ bool qxgeditXGMasterMap::set_sysex_data (
 		}
 	}
 
+	// Single notification pass (and bulk feedback)...
+	begin_bulk();
+	commit_transaction();
+	end_bulk();
+
 	return (nparam > 0);
 }
 
 
+// Master observer of a parameter (deferred notification sender).
+XGParamObserver *qxgeditXGMasterMap::master_observer ( XGParam *pParam ) const
+{
+	return m_observers.value(pParam, nullptr);
+}
+
+
+// Late materialized parameter notification.
+void qxgeditXGMasterMap::param_added ( XGParam *pParam )
+{
+	if (!m_observers.contains(pParam)) {
+		m_observers.insert(pParam, new (XGParamMasterMap::arena()
+			.alloc(sizeof(Observer))) Observer(pParam));
+	}
+}
+
+
 // Direct parameter data access.
 bool qxgeditXGMasterMap::set_param_data (
 	XGParam *pParam, unsigned char *data, bool bNotify )
@@ -271,6 +374,10 @@ bool qxgeditXGMasterMap::set_param_data (
 		pParam->set_value(pParam->data_value(data), pObserver);
 	}
 
+	// Not an edit (not journaled)...
+	if (pObserver)
+		journal_sync(pParam);
+
 #ifdef CONFIG_DEBUG
 	fprintf(stderr, "< %02x %02x %02x",
 		pParam->high(),
@@ -308,6 +415,8 @@ void qxgeditXGMasterMap::reset_all (void)
 
 	reset_part_dirty();
 	reset_user_dirty();
+
+	clear_journal();
 }
 
 
@@ -318,15 +427,13 @@ void qxgeditXGMasterMap::reset_part ( unsigned short iPart )
 	qDebug("qxgeditXGMasterMap::reset_part(%u)", iPart);
 #endif
 
-	XGParamMap::const_iterator iter = MULTIPART.constBegin();
-	for (; iter != MULTIPART.constEnd(); ++iter) {
-		XGParamSet *pParamSet = iter.value();
-		if (pParamSet->contains(iPart)) {
-			XGParam *pParam = pParamSet->value(iPart);
-			if (pParam)
-				pParam->reset();
-		}
-	}
+	begin_bulk();
+
+	QListIterator<XGParam *> iter(MULTIPART.key_params(iPart));
+	while (iter.hasNext())
+		iter.next()->reset();
+
+	end_bulk();
 
 	if (part_dirty(iPart)) {
 		send_part(iPart);
@@ -346,8 +453,10 @@ void qxgeditXGMasterMap::reset_drums ( unsigned short iDrumSet )
 	ObserverMap::const_iterator iter = m_observers.constBegin();
 	for (; iter != m_observers.constEnd(); ++iter) {
 		XGParam *pParam = iter.key();
-		if (pParam->high() == high)
+		if (pParam->high() == high) {
 			pParam->reset(iter.value());
+			journal_sync(pParam);
+		}
 	}
 }
 
@@ -363,15 +472,9 @@ void qxgeditXGMasterMap::reset_user ( unsigned short iUser )
 	bool bAuto = auto_send();
 	set_auto_send(false);
 
-	XGParamMap::const_iterator iter = USERVOICE.constBegin();
-	for (; iter != USERVOICE.constEnd(); ++iter) {
-		XGParamSet *pParamSet = iter.value();
-		if (pParamSet->contains(iUser)) {
-			XGParam *pParam = pParamSet->value(iUser);
-			if (pParam)
-				pParam->reset();
-		}
-	}
+	QListIterator<XGParam *> iter(USERVOICE.key_params(iUser));
+	while (iter.hasNext())
+		iter.next()->reset();
 
 	if (user_dirty(iUser)) {
 		send_user(iUser);
@@ -383,16 +486,33 @@ void qxgeditXGMasterMap::reset_user ( unsigned short iUser )
 }
 
 
-// Send regular XG Parameter change SysEx message.
+// Send regular XG Parameter change SysEx message
+// (or NRPN message, when mapped and enabled).
 void qxgeditXGMasterMap::send_param ( XGParam *pParam )
 {
 	if (pParam == nullptr)
 		return;
 
+	// Defer to bulk-send batch, if any...
+	if (m_bulk > 0 && pParam->high() != 0x00) {
+		m_bulk_params.append(pParam);
+		return;
+	}
+
 	qxgeditMidiDevice *pMidiDevice = qxgeditMidiDevice::getInstance();
 	if (pMidiDevice == nullptr)
 		return;
 
+	// Send it out as NRPN, if mapped and enabled...
+	if (m_nrpn_output) {
+		unsigned short nrpn = 0;
+		const int ch = nrpn_channel(pParam, nrpn);
+		if (ch >= 0) {
+			pMidiDevice->sendNrpn(ch, nrpn, pParam->value());
+			return;
+		}
+	}
+
 	// Build the complete SysEx message...
 	XGParamSysex sysex(pParam);
 	// Send it out...
@@ -416,22 +536,18 @@ void qxgeditXGMasterMap::send_param ( XGParam *pParam )
 // Send Multi Part Bank Select/Program Number SysEx messages.
 void qxgeditXGMasterMap::send_part ( unsigned short iPart ) const
 {
-	qxgeditMidiDevice *pMidiDevice = qxgeditMidiDevice::getInstance();
-	if (pMidiDevice == nullptr)
-		return;
-
 	unsigned short high = 0x08;
 	unsigned short mid  = iPart;
 
+	Params params;
 	for (unsigned short low = 0x01; low < 0x04; ++low) {
 		XGParam *pParam = find_param(high, mid, low);
-		if (pParam) {
-			// Build the complete SysEx message...
-			XGParamSysex sysex(pParam);
-			// Send it out...
-			pMidiDevice->sendSysex(sysex.data(), sysex.size());
-		}
+		if (pParam)
+			params.append(pParam);
 	}
+
+	// Bank Select MSB/LSB and Program Number, all in one...
+	send_params(params);
 }
 
 
@@ -442,13 +558,129 @@ void qxgeditXGMasterMap::send_user ( unsigned short iUser ) const
 	if (pMidiDevice == nullptr)
 		return;
 
-	// Build the complete SysEx message...
-	XGUserVoiceSysex sysex(iUser);
+	// Build the complete SysEx message (on stack)...
+	unsigned char data[XGUserVoiceSysex::Size];
+	XGUserVoiceSysex sysex(iUser, data);
 	// Send it out...
 	pMidiDevice->sendSysex(sysex.data(), sysex.size());
 }
 
 
+// Parameter address ordering (sort helper).
+static bool qxgedit_param_less ( XGParam *pParam1, XGParam *pParam2 )
+{
+	if (pParam1->high() != pParam2->high())
+		return (pParam1->high() < pParam2->high());
+	if (pParam1->mid() != pParam2->mid())
+		return (pParam1->mid() < pParam2->mid());
+	return (pParam1->low() < pParam2->low());
+}
+
+// Parameter address equality (unique helper).
+static bool qxgedit_param_equal ( XGParam *pParam1, XGParam *pParam2 )
+{
+	return pParam1->high() == pParam2->high()
+		&& pParam1->mid()  == pParam2->mid()
+		&& pParam1->low()  == pParam2->low();
+}
+
+
+// Pack XG parameters into Bulk Dump (or Parameter Change) messages.
+void qxgeditXGMasterMap::pack_params (
+	Params& params, SysexList& sysex_list ) const
+{
+	// Live params only: non-current effect type params would
+	// otherwise land on the current effect type addresses...
+	int iLive = 0;
+	for (int i = 0; i < params.count(); ++i) {
+		XGParam *pParam = params.at(i);
+		if (pParam == find_param(pParam->high(), pParam->mid(), pParam->low()))
+			params[iLive++] = pParam;
+	}
+	params.erase(params.begin() + iLive, params.end());
+
+	// Address order, no duplicates (one live param per address)...
+	std::sort(params.begin(), params.end(), qxgedit_param_less);
+	params.erase(std::unique(params.begin(), params.end(),
+		qxgedit_param_equal), params.end());
+
+	XGParam *const *pParams = params.constData();
+	const int iCount = params.count();
+
+	int i = 0;
+	while (i < iCount) {
+		const unsigned short n
+			= XGParamBulkSysex::run(pParams + i, iCount - i);
+		if (n > 1) {
+			// Native Bulk Dump...
+			XGParamBulkSysex sysex(pParams + i, n);
+			sysex_list.append(
+				QByteArray((const char *) sysex.data(), sysex.size()));
+		} else {
+			// Parameter Change...
+			XGParamSysex sysex(pParams[i]);
+			sysex_list.append(
+				QByteArray((const char *) sysex.data(), sysex.size()));
+		}
+		i += n;
+	}
+}
+
+
+// Send XG parameters as Bulk Dump (or Parameter Change) messages.
+void qxgeditXGMasterMap::send_params ( Params& params ) const
+{
+	qxgeditMidiDevice *pMidiDevice = qxgeditMidiDevice::getInstance();
+	if (pMidiDevice == nullptr)
+		return;
+
+	SysexList sysex_list;
+	pack_params(params, sysex_list);
+
+	int iBytes = 0;
+	QListIterator<QByteArray> iter(sysex_list);
+	while (iter.hasNext()) {
+		const QByteArray& sysex = iter.next();
+		pMidiDevice->sendSysex(sysex);
+		iBytes += sysex.size();
+	}
+
+#ifdef CONFIG_DEBUG
+	qDebug("qxgeditXGMasterMap::send_params(%d) messages=%d bytes=%d",
+		params.count(), sysex_list.count(), iBytes);
+#endif
+}
+
+
+// Bulk-send batch mode (nestable).
+void qxgeditXGMasterMap::begin_bulk (void)
+{
+	++m_bulk;
+}
+
+void qxgeditXGMasterMap::end_bulk (void)
+{
+	if (m_bulk < 1 || --m_bulk > 0)
+		return;
+
+	m_journal_batch = false;
+
+	if (!m_bulk_params.isEmpty()) {
+		Params params = m_bulk_params;
+		m_bulk_params.clear();
+		send_params(params);
+	}
+
+	// HACK: Flag dirty the main form, just once...
+	if (m_bulk_dirty) {
+		m_bulk_dirty = false;
+		qxgeditMainForm *pMainForm = qxgeditMainForm::getInstance();
+		if (pMainForm)
+			pMainForm->contentsChanged();
+	}
+}
+
+
 // MULTIPART dirty slot simple managing.
 void qxgeditXGMasterMap::reset_part_dirty (void)
 {
@@ -539,6 +771,73 @@ bool qxgeditXGMasterMap::auto_send (void) const
 }
 
 
+// NRPN output mode (for NRPN mapped parameters).
+void qxgeditXGMasterMap::set_nrpn_output ( bool bNrpn )
+{
+	m_nrpn_output = bNrpn;
+}
+
+bool qxgeditXGMasterMap::nrpn_output (void) const
+{
+	return m_nrpn_output;
+}
+
+
+// NRPN output target channel (-1 if none, or not unique).
+int qxgeditXGMasterMap::nrpn_channel (
+	XGParam *pParam, unsigned short& nrpn ) const
+{
+	if (pParam == nullptr || pParam->size() > 1)
+		return -1;
+
+	unsigned short key = 0;
+	if (!XGParamMasterMap::nrpn_param(pParam, key, nrpn))
+		return -1;
+
+	XGParamSet *pChannelSet = MULTIPART.value(0x04, nullptr);
+	XGParamSet *pModeSet = MULTIPART.value(0x07, nullptr);
+	if (pChannelSet == nullptr || pModeSet == nullptr)
+		return -1;
+
+	// Which part to address...
+	int iPart = -1;
+	if (nrpn < 2560) {
+		iPart = key;
+	} else {
+		// First part in drum mode, for the given drumset...
+		for (unsigned short i = 0; i < 16 && iPart < 0; ++i) {
+			XGParam *pMode = pModeSet->value(i, nullptr);
+			if (pMode == nullptr)
+				continue;
+			const unsigned short mode = pMode->value();
+			if (mode > 0 && (mode == 3 ? 1 : 0) == key)
+				iPart = i;
+		}
+	}
+	if (iPart < 0)
+		return -1;
+
+	XGParam *pChannel = pChannelSet->value(iPart, nullptr);
+	if (pChannel == nullptr)
+		return -1;
+
+	const int ch = pChannel->value();
+	if (ch > 15)
+		return -1;
+
+	// Parts sharing the same receive channel would all get it...
+	for (unsigned short i = 0; i < 16; ++i) {
+		if (int(i) == iPart)
+			continue;
+		XGParam *pOther = pChannelSet->value(i, nullptr);
+		if (pOther && int(pOther->value()) == ch)
+			return -1;
+	}
+
+	return ch;
+}
+
+
 // Part randomize (from value/def)
 void qxgeditXGMasterMap::randomize_part ( unsigned short iPart, float p )
 {
@@ -546,16 +845,17 @@ void qxgeditXGMasterMap::randomize_part ( unsigned short iPart, float p )
 	qDebug("qxgeditXGMasterMap::randomize_part(%u, %g)", iPart, p);
 #endif
 
-	XGParamMap::const_iterator iter = MULTIPART.constBegin();
-	for (; iter != MULTIPART.constEnd(); ++iter) {
-		XGParamSet *pParamSet = iter.value();
-		if (pParamSet->contains(iPart)) {
-			XGParam *pParam = pParamSet->value(iPart);
-			if (pParam && pParam->low() > 0x04)
-				pParam->randomize_value(p);
-		}
+	begin_bulk();
+
+	QListIterator<XGParam *> iter(MULTIPART.key_params(iPart));
+	while (iter.hasNext()) {
+		XGParam *pParam = iter.next();
+		if (pParam->low() > 0x04)
+			pParam->randomize_value(p);
 	}
 
+	end_bulk();
+
 	if (part_dirty(iPart)) {
 		send_part(iPart);
 		set_part_dirty(iPart, false);
@@ -571,16 +871,14 @@ void qxgeditXGMasterMap::randomize_drums (
 	qDebug("qxgeditXGMasterMap::randomize_drums(%u, %u, %g)", iDrumSet, iDrumKey, p);
 #endif
 
+	begin_bulk();
+
 	unsigned short key = (unsigned short) (iDrumSet << 7) + iDrumKey;
-	XGParamMap::const_iterator iter = DRUMSETUP.constBegin();
-	for (; iter != DRUMSETUP.constEnd(); ++iter) {
-		XGParamSet *pParamSet = iter.value();
-		if (pParamSet->contains(key)) {
-			XGParam *pParam = pParamSet->value(key);
-			if (pParam)
-				pParam->randomize_value(p);
-		}
-	}
+	QListIterator<XGParam *> iter(DRUMSETUP.key_params(key));
+	while (iter.hasNext())
+		iter.next()->randomize_value(p);
+
+	end_bulk();
 }
 
 
@@ -596,19 +894,15 @@ void qxgeditXGMasterMap::randomize_user ( unsigned short iUser, float p )
 	set_auto_send(false);
 
 	unsigned short id0 = 0x3d + (USERVOICE.current_element() * 0x50);
-	XGParamMap::const_iterator iter = USERVOICE.constBegin();
-	for (; iter != USERVOICE.constEnd(); ++iter) {
-		unsigned short id = iter.key();
+	QListIterator<XGParam *> iter(USERVOICE.key_params(iUser));
+	while (iter.hasNext()) {
+		XGParam *pParam = iter.next();
+		unsigned short id = pParam->low();
 		if (id < 0x3d)
 			continue;
 		if (USERVOICE.elements() > 0 && (id < id0 || id >= id0 + 0x50))
 			continue;
-		XGParamSet *pParamSet = iter.value();
-		if (pParamSet->contains(iUser)) {
-			XGParam *pParam = pParamSet->value(iUser);
-			if (pParam)
-				pParam->randomize_value(p);
-		}
+		pParam->randomize_value(p);
 	}
 
 	if (user_dirty(iUser)) {
@@ -621,4 +915,244 @@ void qxgeditXGMasterMap::randomize_user ( unsigned short iUser, float p )
 }
 
 
+// Copy-on-write state snapshot (value plane blocks, shared).
+void qxgeditXGMasterMap::take_snapshot ( Snapshot& snapshot )
+{
+	const unsigned int nblocks = plane_blocks();
+	const unsigned short *values = XGParamMasterMap::values();
+
+	// Unchanged blocks are shared with the last snapshot...
+	const bool bShare = (m_snapshot.count() == int(nblocks));
+
+	snapshot.clear();
+	snapshot.reserve(nblocks);
+
+	for (unsigned int i = 0; i < nblocks; ++i) {
+		const unsigned int offset = plane_block(i);
+		const int nbytes = (plane_block(i + 1) - offset) * sizeof(unsigned short);
+		const char *data = (const char *) (values + offset);
+		if (bShare) {
+			const QByteArray& block = m_snapshot.at(i);
+			if (::memcmp(block.constData(), data, nbytes) == 0) {
+				snapshot.append(block);
+				continue;
+			}
+		}
+		snapshot.append(QByteArray(data, nbytes));
+	}
+
+	m_snapshot = snapshot;
+}
+
+
+// Snapshot recall (sends the delta only; returns changed params).
+int qxgeditXGMasterMap::recall_snapshot ( const Snapshot& snapshot )
+{
+	const unsigned int nblocks = plane_blocks();
+	if (snapshot.count() != int(nblocks))
+		return 0;
+
+#ifdef CONFIG_DEBUG
+	qDebug("qxgeditXGMasterMap::recall_snapshot()");
+#endif
+
+	const unsigned short *values = XGParamMasterMap::values();
+
+	int nparams = 0;
+
+	// Apply all in one batch (deferred notifications)...
+	begin_bulk();
+	begin_transaction();
+
+	for (unsigned int i = 0; i < nblocks; ++i) {
+		const unsigned int offset = plane_block(i);
+		const unsigned int nvalues = plane_block(i + 1) - offset;
+		const unsigned short *svalues
+			= (const unsigned short *) snapshot.at(i).constData();
+		if (::memcmp(values + offset, svalues,
+				nvalues * sizeof(unsigned short)) == 0)
+			continue;
+		for (unsigned int k = 0; k < nvalues; ++k) {
+			if (values[offset + k] == svalues[k])
+				continue;
+			XGParam *pParam = index_param(offset + k);
+			if (pParam && pParam == find_param(
+					pParam->high(), pParam->mid(), pParam->low())) {
+				pParam->set_value(svalues[k]);
+				++nparams;
+			} else {
+				// Non-current effect type (or not materialized)
+				// slot: local value only, nothing to send...
+				set_index_value(offset + k, svalues[k]);
+			}
+		}
+	}
+
+	commit_transaction();
+	end_bulk();
+
+	m_snapshot = snapshot;
+
+	return nparams;
+}
+
+
+// Undo/redo journal (coalesced parameter edits).
+bool qxgeditXGMasterMap::undo (void)
+{
+	if (m_journal_pos < 1)
+		return false;
+
+	const unsigned int step = journal_item(m_journal_pos - 1).step;
+
+	// Replay the whole step in one batch, backwards...
+	m_journal_replay = true;
+	begin_bulk();
+	begin_transaction();
+
+	while (m_journal_pos > 0) {
+		const JournalItem& item = journal_item(m_journal_pos - 1);
+		if (item.step != step)
+			break;
+		XGParam *pParam = index_param(item.index);
+		if (pParam)
+			pParam->set_value(item.old_value);
+		--m_journal_pos;
+	}
+
+	commit_transaction();
+	end_bulk();
+	m_journal_replay = false;
+
+	return true;
+}
+
+
+bool qxgeditXGMasterMap::redo (void)
+{
+	if (m_journal_pos >= m_journal_count)
+		return false;
+
+	const unsigned int step = journal_item(m_journal_pos).step;
+
+	// Replay the whole step in one batch, forward...
+	m_journal_replay = true;
+	begin_bulk();
+	begin_transaction();
+
+	while (m_journal_pos < m_journal_count) {
+		const JournalItem& item = journal_item(m_journal_pos);
+		if (item.step != step)
+			break;
+		XGParam *pParam = index_param(item.index);
+		if (pParam)
+			pParam->set_value(item.new_value);
+		++m_journal_pos;
+	}
+
+	commit_transaction();
+	end_bulk();
+	m_journal_replay = false;
+
+	return true;
+}
+
+
+bool qxgeditXGMasterMap::can_undo (void) const
+{
+	return (m_journal_pos > 0);
+}
+
+bool qxgeditXGMasterMap::can_redo (void) const
+{
+	return (m_journal_pos < m_journal_count);
+}
+
+
+void qxgeditXGMasterMap::clear_journal (void)
+{
+	m_journal_begin = 0;
+	m_journal_count = 0;
+	m_journal_pos = 0;
+	m_journal_batch = false;
+
+	::memcpy(m_journal_values, values(), plane_size() * sizeof(unsigned short));
+}
+
+
+// Undo/redo journal recorders.
+void qxgeditXGMasterMap::journal_add ( XGParam *pParam )
+{
+	if (pParam->size() > 4)
+		return;
+
+	const int index = param_index(pParam);
+	if (index < 0)
+		return;
+
+	const unsigned short old_value = m_journal_values[index];
+	const unsigned short new_value = pParam->value();
+	m_journal_values[index] = new_value;
+
+	if (m_journal_replay || old_value == new_value)
+		return;
+
+	const unsigned int stamp = m_journal_timer.elapsed();
+	const bool bBatch = (m_bulk > 0);
+
+	// Any redo tail is gone now...
+	m_journal_count = m_journal_pos;
+
+	// Coalesce single edits on the same param (eg. dragging)...
+	if (!bBatch && m_journal_count > 0) {
+		JournalItem& last = journal_item(m_journal_count - 1);
+		if (last.index == (unsigned int) index
+			&& stamp - last.stamp < JournalCoalesce
+			&& (m_journal_count < 2
+				|| journal_item(m_journal_count - 2).step != last.step)) {
+			last.new_value = new_value;
+			last.stamp = stamp;
+			if (last.new_value == last.old_value)
+				m_journal_pos = --m_journal_count;
+			return;
+		}
+	}
+
+	if (!bBatch || !m_journal_batch)
+		++m_journal_step;
+
+	m_journal_batch = bBatch;
+
+	// Bounded ring: drop the oldest...
+	if (m_journal_count >= JournalSize) {
+		m_journal_begin = (m_journal_begin + 1) % JournalSize;
+		--m_journal_count;
+	}
+
+	JournalItem& item = journal_item(m_journal_count++);
+	item.index = index;
+	item.old_value = old_value;
+	item.new_value = new_value;
+	item.stamp = stamp;
+	item.step = m_journal_step;
+
+	m_journal_pos = m_journal_count;
+}
+
+
+void qxgeditXGMasterMap::journal_sync ( XGParam *pParam )
+{
+	const int index = param_index(pParam);
+	if (index >= 0)
+		m_journal_values[index] = pParam->value();
+}
+
+
+qxgeditXGMasterMap::JournalItem& qxgeditXGMasterMap::journal_item (
+	unsigned int i ) const
+{
+	return m_journal[(m_journal_begin + i) % JournalSize];
+}
+
+
 // end of qxgeditXGMasterMap.cpp
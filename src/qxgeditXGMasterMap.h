@@ -25,6 +25,10 @@
 #include "XGParam.h"
 
 #include <QByteArray>
+#include <QList>
+#include <QVector>
+
+#include <QElapsedTimer>
 
 
 //----------------------------------------------------------------------------
@@ -74,7 +78,8 @@ public:
 	// User voice reset (to default)
 	void reset_user(unsigned short iUser);
 
-	// Send regular XG Parameter change SysEx message.
+	// Send regular XG Parameter change SysEx message
+	// (or NRPN message, when mapped and enabled).
 	void send_param(XGParam *pParam);
 
 	// Send Multi Part Bank Select/Program Number SysEx messages.
@@ -83,6 +88,18 @@ public:
 	// Send (QS300) USERVOICE Bulk Dump SysEx message.
 	void send_user(unsigned short iUser) const;
 
+	// Pack XG parameters into Bulk Dump (or Parameter Change) messages.
+	typedef QList<QByteArray> SysexList;
+
+	void pack_params(Params& params, SysexList& sysex_list) const;
+
+	// Send XG parameters as Bulk Dump (or Parameter Change) messages.
+	void send_params(Params& params) const;
+
+	// Bulk-send batch mode (nestable).
+	void begin_bulk();
+	void end_bulk();
+
 	// MULTPART dirty slot simple managers.
 	void reset_part_dirty();
 	void set_part_dirty(unsigned short iPart, bool bDirty);
@@ -103,6 +120,13 @@ public:
 	void set_auto_send(bool bAuto);
 	bool auto_send() const;
 
+	// NRPN output mode (for NRPN mapped parameters).
+	void set_nrpn_output(bool bNrpn);
+	bool nrpn_output() const;
+
+	// NRPN output target channel (-1 if none, or not unique).
+	int nrpn_channel(XGParam *pParam, unsigned short& nrpn) const;
+
 	// Part randomize (from value/def)
 	void randomize_part(unsigned short iPart, float p = 20.0f);
 
@@ -113,6 +137,31 @@ public:
 	// User voice randomize (from value/def)
 	void randomize_user(unsigned short iUser, float p = 20.0f);
 
+	// Copy-on-write state snapshot (value plane blocks, shared).
+	typedef QVector<QByteArray> Snapshot;
+
+	void take_snapshot(Snapshot& snapshot);
+
+	// Snapshot recall (sends the delta only; returns changed params).
+	int recall_snapshot(const Snapshot& snapshot);
+
+	// Undo/redo journal (coalesced parameter edits).
+	bool undo();
+	bool redo();
+
+	bool can_undo() const;
+	bool can_redo() const;
+
+	void clear_journal();
+
+	// Master observer of a parameter (deferred notification sender).
+	XGParamObserver *master_observer(XGParam *pParam) const;
+
+protected:
+
+	// Late materialized parameter notification.
+	void param_added(XGParam *pParam);
+
 private:
 
 	// Simple XGParam observer.
@@ -130,6 +179,25 @@ private:
 	// Local observer map.
 	typedef QHash<XGParam *, Observer *> ObserverMap;
 
+	// Undo/redo journal item.
+	struct JournalItem
+	{
+		unsigned int   index;
+		unsigned short old_value;
+		unsigned short new_value;
+		unsigned int   stamp;
+		unsigned int   step;
+	};
+
+	// Undo/redo journal ring size and coalescing window (msecs).
+	enum { JournalSize = 4096, JournalCoalesce = 1000 };
+
+	// Undo/redo journal recorders.
+	void journal_add(XGParam *pParam);
+	void journal_sync(XGParam *pParam);
+
+	JournalItem& journal_item(unsigned int i) const;
+
 	// Instance variables.
 	ObserverMap m_observers;
 
@@ -141,6 +209,28 @@ private:
 
 	// QS300 User Voice auto-send feature.
 	bool m_auto_send;
+
+	// NRPN output mode.
+	bool m_nrpn_output;
+
+	// Bulk-send batch mode state.
+	int    m_bulk;
+	Params m_bulk_params;
+	bool   m_bulk_dirty;
+
+	// Last taken/recalled snapshot (block sharing reference).
+	Snapshot m_snapshot;
+
+	// Undo/redo journal ring (preallocated).
+	JournalItem   *m_journal;
+	unsigned int   m_journal_begin;
+	unsigned int   m_journal_count;
+	unsigned int   m_journal_pos;
+	unsigned int   m_journal_step;
+	bool           m_journal_batch;
+	bool           m_journal_replay;
+	unsigned short *m_journal_values;
+	QElapsedTimer  m_journal_timer;
 };
 
 
@@ -15,6 +15,7 @@ HEADERS += config.h \
 	XGParamWidget.h \
 	XGParamSysex.h \
 	qxgeditXGMasterMap.h \
+	qxgeditXGDumpRequest.h \
 	qxgeditAbout.h \
 	qxgeditAmpEg.h \
 	qxgeditCheck.h \
@@ -33,6 +34,8 @@ HEADERS += config.h \
 	qxgeditVibra.h \
 	qxgeditMidiDevice.h \
 	qxgeditMidiRpn.h \
+	qxgeditProfile.h \
+	qxgeditBench.h \
 	qxgeditOptions.h \
 	qxgeditOptionsForm.h \
 	qxgeditPaletteForm.h \
@@ -45,6 +48,7 @@ SOURCES += \
 	XGParamWidget.cpp \
 	XGParamSysex.cpp \
 	qxgeditXGMasterMap.cpp \
+	qxgeditXGDumpRequest.cpp \
 	qxgeditAmpEg.cpp \
 	qxgeditCheck.cpp \
 	qxgeditCombo.cpp \
@@ -62,6 +66,8 @@ SOURCES += \
 	qxgeditVibra.cpp \
 	qxgeditMidiDevice.cpp \
 	qxgeditMidiRpn.cpp \
+	qxgeditProfile.cpp \
+	qxgeditBench.cpp \
 	qxgeditOptions.cpp \
 	qxgeditOptionsForm.cpp \
 	qxgeditPaletteForm.cpp \